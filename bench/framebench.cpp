@@ -0,0 +1,649 @@
+// Headless frame-build benchmark for the editor UI.
+// Runs ImGui with no window and no renderer, replays an input script of pans, zooms, drags and selections
+// against a level, and reports how long each frame takes to build and how much geometry it produces.
+
+#include "alloctracker.h"
+#include "editor.h"
+#include "framestats.h"
+#include "global.h"
+#include "inputscript.h"
+#include "profiler.h"
+#include "visualizer.h"
+
+#include "imgui.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifdef MWG_ALLOC_TRACKING
+
+// The tracker already replaces operator new and counts everything
+static size_t heapAllocCount() { return allocStatsSnapshot().total().count; }
+static void* countingImGuiAlloc(size_t size, void* userData) { return trackedMalloc(size, userData); }
+static void imGuiFree(void* ptr, void* userData) { trackedFree(ptr, userData); }
+
+#else
+
+// Every heap allocation the process makes, through operator new or ImGui's allocator
+static std::atomic<size_t> s_heapAllocs{0};
+
+void* operator new(size_t size)
+{
+    s_heapAllocs.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+
+static size_t heapAllocCount() { return s_heapAllocs; }
+
+static void* countingImGuiAlloc(size_t size, void*)
+{
+    s_heapAllocs.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size);
+}
+
+static void imGuiFree(void* ptr, void*)
+{
+    std::free(ptr);
+}
+
+#endif
+
+constexpr float FRAME_DT = 1.f / 60;
+static const ImVec2 DISPLAY_SIZE(1280, 720);
+
+// Fixed window layout, so recorded mouse positions land on the same widgets every run
+static const char* BENCH_LAYOUT_INI = R"(
+[Window][Level Visualizer]
+Pos=0,0
+Size=880,720
+Collapsed=0
+
+[Window][Properties Editor]
+Pos=880,0
+Size=400,420
+Collapsed=0
+
+[Window][Recipe Editor]
+Pos=880,420
+Size=400,300
+Collapsed=0
+)";
+
+struct BenchOptions
+{
+    std::string levelFile; // Generate a synthetic level if empty
+    std::string scriptFile; // Use the built-in scenario if empty
+    std::string saveScriptFile;
+    std::string csvFile;
+    std::string allocStatsFile;
+    std::string traceFile;
+    int numPlanets = 2000;
+    int numFoods = 500;
+    int cycles = 10;
+    int skipFrames = 5; // Left out of the stats while the windows settle into the layout
+    bool canvasCache = true;
+    bool checkAllocs = false;
+    bool checkUndo = false;
+};
+
+static void printUsage()
+{
+    printf("Usage: mwgbench [options]\n"
+           "  --level <file.json>    Benchmark a real level (must be run inside the game repo)\n"
+           "  --planets <n>          Planets in the synthetic level (default 2000)\n"
+           "  --foods <n>            Foods in the synthetic level (default 500)\n"
+           "  --script <file>        Replay an input script instead of the built-in scenario\n"
+           "  --save-script <file>   Save the replayed input script\n"
+           "  --cycles <n>           Repetitions of the built-in scenario (default 10)\n"
+           "  --skip <n>             Frames at the start to leave out of the stats (default 5)\n"
+           "  --csv <file>           Write per-frame timings\n"
+           "  --alloc-stats <file>   Write per-frame allocations by subsystem (needs MWG_ALLOC_TRACKING)\n"
+           "  --trace <file>         Write profiler zones as a Chrome trace (needs MWG_PROFILER)\n"
+           "  --no-canvas-cache      Rebuild the canvas sprites every frame\n"
+           "  --check-allocs         Replay the script a second time and fail if those frames allocate\n"
+           "  --check-undo           Fail unless undoing a batch delete puts the level back exactly\n");
+}
+
+// Nothing gets bound, but every texture and thumbnail needs its own id, or ImGui merges all the sprites into one
+// draw command and the draw and bind counts can't show a batching regression
+static ImTextureID nextFakeTextureId()
+{
+    static intptr_t lastId = 0;
+    return reinterpret_cast<ImTextureID>(++lastId);
+}
+
+static std::shared_ptr<Texture> makeFakeTexture(const std::string& shortName, int width, int height)
+{
+    auto tex = std::make_shared<Texture>();
+    tex->id = nextFakeTextureId();
+    tex->thumbnailId = nextFakeTextureId();
+    tex->width = width;
+    tex->height = height;
+    tex->shortName = shortName;
+    return tex;
+}
+
+static ObjectId addFakeObject(LevelObjects& objects, ObjectKind kind, const std::shared_ptr<Texture>& tex, ImVec2 pos)
+{
+    ObjectId obj = objects.add(kind, tex);
+    size_t row = objects.rowOf(obj);
+    objects.pos[row] = pos;
+    objects.scale[row] = 0.5;
+    return obj;
+}
+
+// Planets on a jittered grid at roughly the density of a hand-made level, with foods scattered between them
+static std::shared_ptr<LevelModel> generateLevel(int numPlanets, int numFoods)
+{
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> jitter(-120.f, 120.f);
+
+    constexpr float SPACING = 500.f;
+    int gridWidth = std::max(1, static_cast<int>(std::ceil(std::sqrt(static_cast<float>(numPlanets)))));
+
+    auto planetTex = makeFakeTexture("planet", 400, 200);
+    auto sunTex = makeFakeTexture("sun", 600, 300);
+    auto foodTex = makeFakeTexture("food", 128, 128);
+
+    auto level = std::make_shared<LevelModel>();
+    level->levelNumber = 1;
+    level->levelTimer = 60;
+
+    LevelObjects& objects = level->objects;
+
+    for (int i = 0; i < numPlanets; i++)
+    {
+        bool isSun = i % 17 == 16;
+        ImVec2 pos((i % gridWidth) * SPACING + jitter(rng), (i / gridWidth) * SPACING + jitter(rng));
+        size_t row = objects.rowOf(addFakeObject(objects, ObjectKind::PLANET, isSun ? sunTex : planetTex, pos));
+        objects.cols[row] = 2;
+        objects.span[row] = 2;
+        objects.planetType[row] = isSun ? PlanetType::SUN : PlanetType::NORMAL;
+        if (i % 4 == 0) objects.flags[row] |= OBJECT_HAS_FOOD;
+        if (i == 0) objects.planetOrder[row] = PlanetOrder::START;
+        else if (i == numPlanets - 1) objects.planetOrder[row] = PlanetOrder::END;
+        else objects.planetOrder[row] = PlanetOrder::MIDDLE;
+    }
+
+    for (int i = 0; i < numFoods; i++)
+    {
+        int cell = static_cast<int>(rng() % std::max(1, numPlanets));
+        ImVec2 pos((cell % gridWidth + 0.5f) * SPACING + jitter(rng), (cell / gridWidth + 0.5f) * SPACING + jitter(rng));
+
+        size_t row = objects.rowOf(addFakeObject(objects, ObjectKind::FOOD, foodTex, pos));
+        if (i % 2 == 0) objects.flags[row] |= OBJECT_COOKABLE;
+        if (i % 3 == 0) objects.flags[row] |= OBJECT_SEASONABLE;
+    }
+
+    level->player = addFakeObject(objects, ObjectKind::PLAYER, makeFakeTexture("player", 128, 128), ImVec2(-SPACING / 2, 0));
+    level->customer = addFakeObject(objects, ObjectKind::CUSTOMER, makeFakeTexture("customer", 128, 128), ImVec2(gridWidth * SPACING, 0));
+
+    return level;
+}
+
+// Deletes every third food (in recipe order, the way a box selection picks them) and a planet as one batch,
+// then checks that undoing it puts every object and the whole recipe back exactly, and that redo deletes them again
+static bool checkBatchDeleteUndo(const LevelModel& original)
+{
+    auto level = std::make_shared<LevelModel>(original);
+    LevelObjects& objects = level->objects;
+    SpatialIndex index;
+    index.rebuild(level);
+    UndoHistory undo;
+
+    Selection selection;
+    std::vector<ObjectId> recipeBefore = objects.recipeOrder();
+    for (size_t i = 1; i < recipeBefore.size(); i += 3) selection.add(recipeBefore[i]);
+    std::vector<size_t> planetRows = objects.rowsOfKind(ObjectKind::PLANET);
+    if (!planetRows.empty()) selection.add(objects.idAt(planetRows.front()));
+    std::vector<ObjectRecord> recordsBefore;
+    for (size_t row = 0; row < objects.size(); row++) recordsBefore.push_back(objects.record(objects.idAt(row)));
+
+    size_t deleted = selection.size();
+    deleteSelection(objects, index, undo, selection);
+    undo.endStep();
+    std::vector<ObjectId> recipeAfterDelete = objects.recipeOrder();
+    undo.undo(*level, index);
+
+    bool same = objects.recipeOrder() == recipeBefore && objects.size() == recordsBefore.size();
+    for (const ObjectRecord& before : recordsBefore)
+    {
+        if (!same) break;
+        same = objects.contains(before.id);
+        if (!same) break;
+        ObjectRecord after = objects.record(before.id);
+        same = after.kind == before.kind && after.pos.x == before.pos.x && after.pos.y == before.pos.y &&
+               after.scale == before.scale && after.planetOrder == before.planetOrder;
+    }
+    undo.redo(*level, index);
+    same = same && objects.recipeOrder() == recipeAfterDelete && objects.size() == recordsBefore.size() - deleted;
+
+    if (same) printf("undo: deleting %zu objects at once and undoing it restored the level\n", deleted);
+    else fprintf(stderr, "undo: deleting %zu objects at once and undoing it didn't restore the level\n", deleted);
+    return same;
+}
+
+static bool objectContainsWorldPos(const LevelObjects& objects, size_t row, ImVec2 worldPos)
+{
+    float scaledWidth = objects.frameSize(row).x * objects.scale[row];
+    float scaledHeight = objects.frameSize(row).y * objects.scale[row];
+
+    return worldPos.x >= (objects.pos[row].x - scaledWidth / 2) &&
+           worldPos.y >= (objects.pos[row].y - scaledHeight / 2) &&
+           worldPos.x <= (objects.pos[row].x + scaledWidth / 2) &&
+           worldPos.y <= (objects.pos[row].y + scaledHeight / 2);
+}
+
+// Generates the built-in scenario one action at a time, aiming each action at whatever is on screen when it
+// starts, so the frames stay meaningful no matter where earlier actions left the camera
+class ScenarioBuilder
+{
+public:
+    explicit ScenarioBuilder(int cycles): m_cycles{cycles}, m_step{0} {}
+
+    // Appends the next action's frames, returns false once the scenario is over
+    bool appendNextAction(InputScript& script)
+    {
+        constexpr int ACTIONS_PER_CYCLE = 8;
+        if (m_step >= m_cycles * ACTIONS_PER_CYCLE) return false;
+
+        switch (m_step++ % ACTIONS_PER_CYCLE)
+        {
+            case 0: appendSelect(script); break;
+            case 1: appendObjectDrag(script); break;
+            case 2: appendPan(script, ImVec2(-300, -150)); break;
+            case 3: appendZoom(script, -1); break;
+            case 4: appendPan(script, ImVec2(-250, -200)); break;
+            case 5: appendZoom(script, 1); break;
+            case 6: appendBoxSelect(script); break;
+            case 7: appendObjectDrag(script); break; // Drags the whole box selection
+        }
+
+        return true;
+    }
+
+private:
+    static ImVec2 canvasCenter()
+    {
+        const Canvas& canvas = g_viz.getCanvas();
+        return ImVec2(canvas.start.x + canvas.size.x / 2, canvas.start.y + canvas.size.y / 2);
+    }
+
+    static bool isWellInsideCanvas(ImVec2 screenPos)
+    {
+        constexpr float MARGIN = 40;
+        const Canvas& canvas = g_viz.getCanvas();
+        return screenPos.x > canvas.start.x + MARGIN && screenPos.x < canvas.end.x - MARGIN &&
+               screenPos.y > canvas.start.y + MARGIN && screenPos.y < canvas.end.y - MARGIN;
+    }
+
+    // Screen position of the visible object closest to the canvas center, skipping the most recent pick
+    // so repeated selections don't keep landing on the same object
+    ImVec2 pickVisibleObject()
+    {
+        ImVec2 center = canvasCenter();
+        const LevelObjects& objects = g_level->objects;
+        ObjectId best = NO_OBJECT;
+        float bestDist = 0;
+        for (size_t row = 0; row < objects.size(); row++)
+        {
+            ImVec2 screenPos = g_viz.worldToScreenSpace(objects.pos[row]);
+            if (objects.idAt(row) == m_lastPicked || !isWellInsideCanvas(screenPos)) continue;
+
+            float dist = std::hypot(screenPos.x - center.x, screenPos.y - center.y);
+            if (!objects.contains(best) || dist < bestDist)
+            {
+                best = objects.idAt(row);
+                bestDist = dist;
+            }
+        }
+
+        if (!objects.contains(best)) return center;
+        m_lastPicked = best;
+        return g_viz.worldToScreenSpace(objects.pos[objects.rowOf(best)]);
+    }
+
+    static ImVec2 pickEmptySpace()
+    {
+        const LevelObjects& objects = g_level->objects;
+        ImVec2 center = canvasCenter();
+
+        // Spiral outwards from the center until we find a spot with nothing under it
+        for (float radius = 0; radius < 400; radius += 20)
+        {
+            for (float angle = 0; angle < 6.28f; angle += 0.5f)
+            {
+                ImVec2 screenPos(center.x + radius * std::cos(angle), center.y + radius * std::sin(angle));
+                if (!isWellInsideCanvas(screenPos)) continue;
+
+                ImVec2 worldPos = g_viz.screenToWorldSpace(screenPos);
+                bool hit = false;
+                for (size_t row = 0; row < objects.size() && !hit; row++)
+                {
+                    hit = objectContainsWorldPos(objects, row, worldPos);
+                }
+                if (!hit) return screenPos;
+            }
+        }
+
+        return center;
+    }
+
+    static void appendFrame(InputScript& script, ImVec2 mousePos, int mouseButtons, float mouseWheel = 0,
+                            int keyMods = 0)
+    {
+        script.frames.push_back(InputFrame{FRAME_DT, mousePos, mouseButtons, mouseWheel, keyMods});
+    }
+
+    static void appendDrag(InputScript& script, ImVec2 from, ImVec2 delta, int moveFrames, int keyMods = 0)
+    {
+        appendFrame(script, from, 0, 0, keyMods);
+        appendFrame(script, from, 1, 0, keyMods);
+        for (int i = 1; i <= moveFrames; i++)
+        {
+            float t = static_cast<float>(i) / moveFrames;
+            appendFrame(script, ImVec2(from.x + delta.x * t, from.y + delta.y * t), 1, 0, keyMods);
+        }
+        appendFrame(script, ImVec2(from.x + delta.x, from.y + delta.y), 0, 0, keyMods);
+    }
+
+    void appendSelect(InputScript& script)
+    {
+        ImVec2 pos = pickVisibleObject();
+        appendFrame(script, pos, 0);
+        appendFrame(script, pos, 1);
+        appendFrame(script, pos, 0);
+        for (int i = 0; i < 10; i++) appendFrame(script, pos, 0);
+    }
+
+    void appendObjectDrag(InputScript& script)
+    {
+        appendDrag(script, pickVisibleObject(), ImVec2(120, 80), 45);
+    }
+
+    // Shift+drag a box centered on the canvas, so the next pickVisibleObject() lands inside it
+    static void appendBoxSelect(InputScript& script)
+    {
+        constexpr int SHIFT = 2;
+        constexpr float MIN_HALF_SIZE = 150;
+        ImVec2 from = pickEmptySpace(), center = canvasCenter();
+        ImVec2 halfSize(std::max(std::abs(center.x - from.x), MIN_HALF_SIZE),
+                        std::max(std::abs(center.y - from.y), MIN_HALF_SIZE));
+        ImVec2 delta(from.x < center.x ? center.x + halfSize.x - from.x : center.x - halfSize.x - from.x,
+                     from.y < center.y ? center.y + halfSize.y - from.y : center.y - halfSize.y - from.y);
+        appendDrag(script, from, delta, 30, SHIFT);
+    }
+
+    static void appendPan(InputScript& script, ImVec2 delta)
+    {
+        appendDrag(script, pickEmptySpace(), delta, 60);
+    }
+
+    static void appendZoom(InputScript& script, float direction)
+    {
+        // Enough wheel steps to sweep the whole zoom range, then linger so the extreme gets measured too
+        ImVec2 pos = canvasCenter();
+        for (int i = 0; i < 15; i++) appendFrame(script, pos, 0, direction);
+        for (int i = 0; i < 30; i++) appendFrame(script, pos, 0);
+    }
+
+    int m_cycles;
+    int m_step;
+    ObjectId m_lastPicked = NO_OBJECT;
+};
+
+// Whole string has to be a non-negative int, unlike with std::stoi
+static bool parseCount(const char* text, int& count)
+{
+    if (!std::isdigit(static_cast<unsigned char>(text[0]))) return false;
+    char* end;
+    errno = 0;
+    long value = std::strtol(text, &end, 10);
+    if (*end != '\0' || errno == ERANGE || value > INT_MAX) return false;
+    count = static_cast<int>(value);
+    return true;
+}
+
+static bool parseArgs(int argc, char** argv, BenchOptions& opts)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--level" && hasValue) opts.levelFile = argv[++i];
+        else if (arg == "--planets" && hasValue && parseCount(argv[i + 1], opts.numPlanets)) i++;
+        else if (arg == "--foods" && hasValue && parseCount(argv[i + 1], opts.numFoods)) i++;
+        else if (arg == "--script" && hasValue) opts.scriptFile = argv[++i];
+        else if (arg == "--save-script" && hasValue) opts.saveScriptFile = argv[++i];
+        else if (arg == "--cycles" && hasValue && parseCount(argv[i + 1], opts.cycles)) i++;
+        else if (arg == "--skip" && hasValue && parseCount(argv[i + 1], opts.skipFrames)) i++;
+        else if (arg == "--csv" && hasValue) opts.csvFile = argv[++i];
+        else if (arg == "--alloc-stats" && hasValue) opts.allocStatsFile = argv[++i];
+        else if (arg == "--trace" && hasValue) opts.traceFile = argv[++i];
+        else if (arg == "--no-canvas-cache") opts.canvasCache = false;
+        else if (arg == "--check-allocs") opts.checkAllocs = true;
+        else if (arg == "--check-undo") opts.checkUndo = true;
+        else return false;
+    }
+    return true;
+}
+
+static void setupHeadlessImGui(const InputScript& script)
+{
+    IMGUI_CHECKVERSION();
+    ImGui::SetAllocatorFunctions(countingImGuiAlloc, imGuiFree);
+    ImGui::CreateContext();
+    ImGuiIO& io = ImGui::GetIO();
+    io.IniFilename = nullptr;
+    io.DisplaySize = script.displaySize;
+    io.DeltaTime = FRAME_DT;
+    ImGui::StyleColorsDark();
+    ImGui::LoadIniSettingsFromMemory(script.iniSettings.c_str());
+
+    // No renderer, but ImGui still needs a built font atlas to lay out text
+    unsigned char* pixels;
+    int width, height;
+    io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+    io.Fonts->TexID = nullptr;
+}
+
+int main(int argc, char** argv)
+{
+    BenchOptions opts;
+    if (!parseArgs(argc, argv, opts))
+    {
+        printUsage();
+        return 1;
+    }
+    if (!opts.allocStatsFile.empty() && !ALLOC_TRACKING_ENABLED)
+    {
+        fprintf(stderr, "--alloc-stats needs a build configured with -DMWG_ALLOC_TRACKING=ON\n");
+        return 1;
+    }
+    if (!opts.traceFile.empty() && !PROFILER_ENABLED)
+    {
+        fprintf(stderr, "--trace needs a build configured with -DMWG_PROFILER=ON\n");
+        return 1;
+    }
+
+    InputScript script;
+    bool useScenario = opts.scriptFile.empty();
+    if (useScenario)
+    {
+        script.displaySize = DISPLAY_SIZE;
+        script.iniSettings = BENCH_LAYOUT_INI;
+        for (int i = 0; i < opts.skipFrames; i++)
+        {
+            script.frames.push_back(InputFrame{FRAME_DT, ImVec2(-FLT_MAX, -FLT_MAX), 0, 0});
+        }
+    }
+    else
+    {
+        try
+        {
+            script = loadInputScript(opts.scriptFile);
+        } catch (const std::exception& ex)
+        {
+            fprintf(stderr, "%s\n", ex.what());
+            return 1;
+        }
+    }
+
+    setupHeadlessImGui(script);
+    setCanvasCacheEnabled(opts.canvasCache);
+
+    // Recordings that load a level themselves start from an empty editor, same as when they were recorded
+    bool scriptLoadsLevel = std::any_of(script.frames.begin(), script.frames.end(), [](auto& frame) {
+        return !frame.levelPath.empty();
+    });
+
+    try
+    {
+        if (!opts.levelFile.empty() || scriptLoadsLevel)
+        {
+            initEditor();
+            if (!opts.levelFile.empty()) openLevelJson(opts.levelFile);
+        }
+        else
+        {
+            g_gravRangeTex = makeFakeTexture("range", 1000, 200);
+            g_gravRangeOutlineTex = makeFakeTexture("range outline", 64, 64);
+            g_showGravRanges = true;
+            g_level = generateLevel(opts.numPlanets, opts.numFoods);
+            g_viz.setWorldPos(g_level->objects.size() == 0 ? ImVec2(0, 0) : g_level->objects.pos[0]);
+        }
+    } catch (const std::exception& ex)
+    {
+        fprintf(stderr, "Could not set up level: %s\n", ex.what());
+        return 1;
+    }
+
+    if (opts.checkUndo)
+    {
+        if (!g_level)
+        {
+            fprintf(stderr, "--check-undo needs a level that the script doesn't load itself\n");
+            return 1;
+        }
+        if (!checkBatchDeleteUndo(*g_level)) return 1;
+    }
+
+    ImGuiIO& io = ImGui::GetIO();
+    ImVec2 startWorldPos = g_viz.getWorldPos();
+    float startZoom = g_viz.getZoom();
+    Selection startSelection = g_selection;
+
+    ScenarioBuilder scenario(opts.cycles);
+    std::vector<FrameStats> stats;
+    std::vector<AllocStats> allocStats;
+
+    InputPlayer player;
+    player.begin(script);
+    for (size_t frame = 0; ; frame++)
+    {
+        if (frame >= script.frames.size() && !(useScenario && scenario.appendNextAction(script))) break;
+
+        auto levelBeforeFrame = g_level;
+        player.applyFrame(io, script.frames[frame]);
+        AllocStats allocsBefore = allocStatsSnapshot();
+        FrameStats frameStats = buildMeasuredFrame(runEditor);
+        if (frame >= static_cast<size_t>(opts.skipFrames))
+        {
+            stats.push_back(frameStats);
+            allocStats.push_back(allocStatsSnapshot() - allocsBefore);
+        }
+
+        try
+        {
+            replayLevelLoad(script.frames[frame].levelPath, levelBeforeFrame);
+        } catch (const std::exception& ex)
+        {
+            fprintf(stderr, "Could not load recorded level: %s\n", ex.what());
+            return 1;
+        }
+    }
+
+    size_t steadyAllocs = 0;
+    size_t allocatingFrames = 0;
+    size_t undoFrames = 0;
+    if (opts.checkAllocs)
+    {
+        if (scriptLoadsLevel || !g_level)
+        {
+            fprintf(stderr, "--check-allocs needs a level that the script doesn't load itself\n");
+            return 1;
+        }
+
+        // Put the level and the camera back how they started and replay the same input. Everything those frames
+        // need was already allocated the first time through, so anything allocated now is per-frame garbage.
+        // Frames that start a new undo step are left out, since those are supposed to allocate.
+        while (g_undo.undo(*g_level, g_levelIndex)) {}
+        g_viz.setWorldPos(startWorldPos);
+        g_viz.setZoom(startZoom);
+        g_selection = startSelection;
+        player.begin(script);
+
+        for (const InputFrame& inputFrame : script.frames)
+        {
+            uint64_t stepsBefore = g_undo.stepsStarted();
+            size_t allocsBefore = heapAllocCount();
+
+            player.applyFrame(io, inputFrame);
+            buildMeasuredFrame(runEditor);
+
+            size_t allocs = heapAllocCount() - allocsBefore;
+            if (g_undo.stepsStarted() != stepsBefore)
+            {
+                undoFrames++;
+                continue;
+            }
+
+            steadyAllocs += allocs;
+            if (allocs > 0) allocatingFrames++;
+        }
+    }
+
+    ImGui::DestroyContext();
+
+    try
+    {
+        if (!opts.saveScriptFile.empty()) saveInputScript(opts.saveScriptFile, script);
+        if (!opts.csvFile.empty()) saveFrameStatsCsv(opts.csvFile, stats);
+        if (!opts.allocStatsFile.empty()) saveAllocStatsCsv(opts.allocStatsFile, allocStats);
+        if (!opts.traceFile.empty()) saveChromeTrace(opts.traceFile);
+    } catch (const std::exception& ex)
+    {
+        fprintf(stderr, "%s\n", ex.what());
+        return 1;
+    }
+
+    if (g_level) printf("%zu frames, %zu planets, %zu foods\n", stats.size(),
+                       g_level->objects.count(ObjectKind::PLANET), g_level->objects.count(ObjectKind::FOOD));
+    else printf("%zu frames, no level loaded\n", stats.size());
+    printFrameStatsSummary(stats);
+
+    if (opts.checkAllocs)
+    {
+        printf("replay: %zu heap allocations in %zu of %zu frames (%zu frames starting undo steps left out)\n",
+               steadyAllocs, allocatingFrames, script.frames.size() - undoFrames, undoFrames);
+        if (steadyAllocs > 0) return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,114 @@
+#include "alloctracker.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <stdexcept>
+
+static const char* TAG_NAMES[ALLOC_TAG_COUNT] = {
+    "untagged", "asset loading", "json load", "json save", "visualizer", "properties", "recipe editor",
+};
+
+const char* allocTagName(AllocTag tag)
+{
+    return TAG_NAMES[static_cast<size_t>(tag)];
+}
+
+AllocCounter AllocStats::total() const
+{
+    AllocCounter sum{0, 0};
+    for (const AllocCounter& tag : tags)
+    {
+        sum.count += tag.count;
+        sum.bytes += tag.bytes;
+    }
+    return sum;
+}
+
+AllocStats operator-(const AllocStats& a, const AllocStats& b)
+{
+    AllocStats diff;
+    for (size_t i = 0; i < ALLOC_TAG_COUNT; i++)
+    {
+        diff.tags[i].count = a.tags[i].count - b.tags[i].count;
+        diff.tags[i].bytes = a.tags[i].bytes - b.tags[i].bytes;
+    }
+    return diff;
+}
+
+void saveAllocStatsCsv(const std::string& filename, const std::vector<AllocStats>& frames)
+{
+    std::ofstream csv(filename);
+    if (!csv) throw std::runtime_error("Could not write allocation stats: " + filename);
+
+    csv << "frame";
+    for (const char* name : TAG_NAMES) csv << ',' << name << " count," << name << " bytes";
+    csv << '\n';
+
+    for (size_t i = 0; i < frames.size(); i++)
+    {
+        csv << i;
+        for (const AllocCounter& tag : frames[i].tags) csv << ',' << tag.count << ',' << tag.bytes;
+        csv << '\n';
+    }
+}
+
+#ifdef MWG_ALLOC_TRACKING
+
+// All constant-initialized, since operator new can run before any static constructors do
+static std::atomic<uint64_t> s_counts[ALLOC_TAG_COUNT];
+static std::atomic<uint64_t> s_bytes[ALLOC_TAG_COUNT];
+static thread_local AllocTag t_currentTag = AllocTag::UNTAGGED;
+
+static void countAlloc(size_t size)
+{
+    auto tag = static_cast<size_t>(t_currentTag);
+    s_counts[tag].fetch_add(1, std::memory_order_relaxed);
+    s_bytes[tag].fetch_add(size, std::memory_order_relaxed);
+}
+
+AllocStats allocStatsSnapshot()
+{
+    AllocStats stats;
+    for (size_t i = 0; i < ALLOC_TAG_COUNT; i++)
+    {
+        stats.tags[i].count = s_counts[i].load(std::memory_order_relaxed);
+        stats.tags[i].bytes = s_bytes[i].load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+void* trackedMalloc(size_t size, void*)
+{
+    countAlloc(size);
+    return std::malloc(size);
+}
+
+void trackedFree(void* ptr, void*)
+{
+    std::free(ptr);
+}
+
+AllocScope::AllocScope(AllocTag tag): m_prevTag{t_currentTag}
+{
+    t_currentTag = tag;
+}
+
+AllocScope::~AllocScope()
+{
+    t_currentTag = m_prevTag;
+}
+
+// The array and nothrow forms all end up in these
+void* operator new(size_t size)
+{
+    countAlloc(size);
+    if (void* ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+
+#endif
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Heap allocation counts broken down by which part of the editor made them. Only does anything in builds
+// configured with -DMWG_ALLOC_TRACKING=ON, which replace the global operator new/delete. Otherwise the scope
+// macro compiles to nothing and the counters stay at zero.
+//
+// Allocations go to the innermost ALLOC_SCOPE on the allocating thread, or UNTAGGED outside of any.
+
+enum class AllocTag : uint8_t
+{
+    UNTAGGED,
+    ASSET_LOADING,
+    JSON_LOAD,
+    JSON_SAVE,
+    VISUALIZER,
+    PROPERTIES,
+    RECIPE_EDITOR,
+    COUNT
+};
+
+constexpr size_t ALLOC_TAG_COUNT = static_cast<size_t>(AllocTag::COUNT);
+
+const char* allocTagName(AllocTag tag);
+
+struct AllocCounter
+{
+    uint64_t count;
+    uint64_t bytes;
+};
+
+struct AllocStats
+{
+    AllocCounter tags[ALLOC_TAG_COUNT];
+
+    AllocCounter total() const;
+};
+
+// Counters only go up, so take the difference of two snapshots to get what happened in between
+AllocStats operator-(const AllocStats& a, const AllocStats& b);
+
+#ifdef MWG_ALLOC_TRACKING
+
+constexpr bool ALLOC_TRACKING_ENABLED = true;
+
+// Everything allocated since startup
+AllocStats allocStatsSnapshot();
+
+// Same signatures as ImGui's allocator functions, so ImGui's own allocations get counted too
+void* trackedMalloc(size_t size, void* userData);
+void trackedFree(void* ptr, void* userData);
+
+class AllocScope
+{
+public:
+    explicit AllocScope(AllocTag tag);
+    ~AllocScope();
+    AllocScope(const AllocScope&) = delete;
+    AllocScope& operator=(const AllocScope&) = delete;
+
+private:
+    AllocTag m_prevTag;
+};
+
+#define ALLOC_SCOPE_CONCAT2(a, b) a##b
+#define ALLOC_SCOPE_CONCAT(a, b) ALLOC_SCOPE_CONCAT2(a, b)
+#define ALLOC_SCOPE(tag) AllocScope ALLOC_SCOPE_CONCAT(allocScope, __LINE__)(tag)
+
+#else
+
+constexpr bool ALLOC_TRACKING_ENABLED = false;
+
+inline AllocStats allocStatsSnapshot() { return AllocStats{}; }
+
+#define ALLOC_SCOPE(tag) ((void)0)
+
+#endif
+
+// One row per frame, with a count and a bytes column per tag
+void saveAllocStatsCsv(const std::string& filename, const std::vector<AllocStats>& frames);
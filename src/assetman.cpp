@@ -1,44 +1,16 @@
 #include "assetman.h"
+#include "alloctracker.h"
+#include "profiler.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
-// About Desktop OpenGL function loaders:
-//  Modern desktop OpenGL doesn't have a standard portable header file to load OpenGL function pointers.
-//  Helper libraries are often used for this purpose! Here we are supporting a few common ones (gl3w, glew, glad).
-//  You may use another loader/header of your choice (glext, glLoadGen, etc.), or chose to manually implement your own.
-#if defined(IMGUI_IMPL_OPENGL_LOADER_GL3W)
-#include <GL/gl3w.h>            // Initialize with gl3wInit()
-#elif defined(IMGUI_IMPL_OPENGL_LOADER_GLEW)
-#include <GL/glew.h>            // Initialize with glewInit()
-#elif defined(IMGUI_IMPL_OPENGL_LOADER_GLAD)
-#include <glad/glad.h>          // Initialize with gladLoadGL()
-#elif defined(IMGUI_IMPL_OPENGL_LOADER_GLBINDING2)
-#define GLFW_INCLUDE_NONE       // GLFW including OpenGL headers causes ambiguity or multiple definition errors.
-#include <glbinding/Binding.h>  // Initialize with glbinding::Binding::initialize()
-#include <glbinding/gl/gl.h>
-using namespace gl;
-#elif defined(IMGUI_IMPL_OPENGL_LOADER_GLBINDING3)
-#define GLFW_INCLUDE_NONE       // GLFW including OpenGL headers causes ambiguity or multiple definition errors.
-#include <glbinding/glbinding.h>// Initialize with glbinding::initialize()
-#include <glbinding/gl/gl.h>
-using namespace gl;
-#else
-#include IMGUI_IMPL_OPENGL_LOADER_CUSTOM
-#endif
-
-// Include glfw3.h after our OpenGL definitions
-#include <GLFW/glfw3.h>
-
-// [Win32] Our example includes a copy of glfw3.lib pre-compiled with VS2010 to maximize ease of testing and compatibility with old VS compilers.
-// To link with VS2010-era libraries, VS2015+ requires linking with legacy_stdio_definitions.lib, which we do using this pragma.
-// Your own project should not be affected, as you are likely to link with a newer binary of GLFW that is adequate for your version of Visual Studio.
-#if defined(_MSC_VER) && (_MSC_VER >= 1900) && !defined(IMGUI_DISABLE_WIN32_FUNCTIONS)
-#pragma comment(lib, "legacy_stdio_definitions")
-#endif
-
+#include <atomic>
 #include <filesystem>
 #include <algorithm>
+#include <cstdio>
+#include <system_error>
+#include <thread>
 
 namespace fs = std::filesystem;
 
@@ -56,10 +28,61 @@ void AssetMan::init()
     }
 
     m_assetPathRoot = currPath / "assets";
+
+    if (!m_uploader) m_uploader = std::make_unique<NullTextureUploader>();
+}
+
+void AssetMan::setUploader(std::unique_ptr<TextureUploader> uploader)
+{
+    m_uploader = std::move(uploader);
 }
 
-// Simple helper function to load an image into a OpenGL texture with common settings
-static std::shared_ptr<Texture> loadTextureFromFile(const char* filename)
+// Box filters the image down to fit in THUMBNAIL_SIZE, keeping the aspect ratio so sprite sheet UVs still line up
+static void* uploadThumbnail(const unsigned char* rgbaPixels, int width, int height, void* fullSizeId,
+                             TextureUploader& uploader)
+{
+    int factor = (std::max(width, height) + THUMBNAIL_SIZE - 1) / THUMBNAIL_SIZE;
+    if (factor <= 1) return fullSizeId;
+
+    int thumbWidth = std::max(1, width / factor);
+    int thumbHeight = std::max(1, height / factor);
+    std::vector<unsigned char> thumbPixels(static_cast<size_t>(thumbWidth) * thumbHeight * 4);
+
+    for (int ty = 0; ty < thumbHeight; ty++)
+    {
+        for (int tx = 0; tx < thumbWidth; tx++)
+        {
+            int sum[4] = {};
+            for (int y = ty * factor; y < (ty + 1) * factor; y++)
+            {
+                const unsigned char* src = rgbaPixels + (static_cast<size_t>(y) * width + tx * factor) * 4;
+                for (int i = 0; i < factor * 4; i++) sum[i % 4] += src[i];
+            }
+
+            unsigned char* dst = &thumbPixels[(static_cast<size_t>(ty) * thumbWidth + tx) * 4];
+            for (int c = 0; c < 4; c++) dst[c] = static_cast<unsigned char>(sum[c] / (factor * factor));
+        }
+    }
+
+    return uploader.upload(thumbPixels.data(), thumbWidth, thumbHeight);
+}
+
+static std::shared_ptr<Texture> uploadTexture(const unsigned char* rgbaPixels, int width, int height,
+                                              TextureUploader& uploader, bool withThumbnail = true)
+{
+    auto outTexture = std::make_shared<Texture>();
+
+    outTexture->id = uploader.upload(rgbaPixels, width, height);
+    outTexture->thumbnailId = withThumbnail ? uploadThumbnail(rgbaPixels, width, height, outTexture->id, uploader)
+                                            : outTexture->id;
+    outTexture->width = width;
+    outTexture->height = height;
+
+    return outTexture;
+}
+
+// Simple helper function to decode an image and hand it to the uploader
+static std::shared_ptr<Texture> loadTextureFromFile(const char* filename, TextureUploader& uploader)
 {
     // Load from file
     int image_width = 0;
@@ -67,26 +90,9 @@ static std::shared_ptr<Texture> loadTextureFromFile(const char* filename)
     unsigned char* image_data = stbi_load(filename, &image_width, &image_height, NULL, 4);
     if (image_data == NULL) return nullptr;
 
-    // Create a OpenGL texture identifier
-    GLuint image_texture;
-    glGenTextures(1, &image_texture);
-    glBindTexture(GL_TEXTURE_2D, image_texture);
-
-    // Setup filtering parameters for display
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    // Upload pixels into texture
-    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image_width, image_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image_data);
+    auto outTexture = uploadTexture(image_data, image_width, image_height, uploader);
     stbi_image_free(image_data);
 
-    auto outTexture = std::make_shared<Texture>();
-
-    outTexture->id = reinterpret_cast<void *>(image_texture);
-    outTexture->width = image_width;
-    outTexture->height = image_height;
-
     return outTexture;
 }
 
@@ -97,12 +103,14 @@ fs::path AssetMan::getAssetPathRoot()
 
 std::shared_ptr<Texture> AssetMan::loadTexture(const std::filesystem::path &absPath, const std::string& shortName)
 {
+    PROFILE_ZONE("AssetMan::loadTexture");
+    ALLOC_SCOPE(AllocTag::ASSET_LOADING);
     auto it = std::find_if(m_textures.begin(), m_textures.end(), [&](auto tex) {
         return tex->filePath == absPath;
     });
     if (it == m_textures.end())
     {
-        auto tex = loadTextureFromFile(absPath.u8string().c_str());
+        auto tex = loadTextureFromFile(absPath.u8string().c_str(), *m_uploader);
         if (!tex)
         {
             throw std::runtime_error("Could not load texture file: " + absPath.string());
@@ -118,6 +126,159 @@ std::shared_ptr<Texture> AssetMan::loadTexture(const std::filesystem::path &absP
     return *it;
 }
 
+std::shared_ptr<Texture> AssetMan::loadTextureAsync(const std::filesystem::path &absPath, const std::string& shortName)
+{
+    ALLOC_SCOPE(AllocTag::ASSET_LOADING);
+    auto it = std::find_if(m_textures.begin(), m_textures.end(), [&](auto tex) {
+        return tex->filePath == absPath;
+    });
+    if (it != m_textures.end()) return *it;
+
+    auto tex = std::make_shared<Texture>();
+    if (!stbi_info(absPath.u8string().c_str(), &tex->width, &tex->height, NULL))
+    {
+        throw std::runtime_error("Could not load texture file: " + absPath.string());
+    }
+    tex->id = nullptr;
+    tex->thumbnailId = nullptr;
+    tex->ready = false;
+    tex->filePath = absPath;
+    tex->shortName = shortName.empty() ? absPath.filename().u8string() : shortName;
+    m_textures.push_back(tex);
+    m_queuedLoads.push_back(tex);
+
+    return tex;
+}
+
+// Magenta and black checks, so a texture that didn't load is hard to miss
+static std::shared_ptr<Texture> makePlaceholderTexture(TextureUploader& uploader)
+{
+    constexpr int SIZE = 16;
+    constexpr int CHECK = 4;
+
+    std::vector<unsigned char> pixels(SIZE * SIZE * 4);
+    for (int y = 0; y < SIZE; y++)
+    {
+        for (int x = 0; x < SIZE; x++)
+        {
+            bool magenta = (x / CHECK + y / CHECK) % 2 == 0;
+            unsigned char* px = &pixels[(y * SIZE + x) * 4];
+            px[0] = magenta ? 255 : 0;
+            px[1] = 0;
+            px[2] = magenta ? 255 : 0;
+            px[3] = 255;
+        }
+    }
+
+    auto tex = uploadTexture(pixels.data(), SIZE, SIZE, uploader, false);
+    tex->shortName = "placeholder";
+    return tex;
+}
+
+void AssetMan::uploadDecoded(DecodeJob& job)
+{
+    Texture& tex = *job.tex;
+    if (!job.pixels)
+    {
+        // It's already laid out in the level, so it gets drawn as a placeholder rather than disappearing
+        std::string message = "Could not load texture file: " + tex.filePath.string();
+        fprintf(stderr, "%s\n", message.c_str());
+        if (!m_loadErrors.empty()) m_loadErrors += '\n';
+        m_loadErrors += message;
+
+        if (!m_placeholder) m_placeholder = makePlaceholderTexture(*m_uploader);
+        tex.id = m_placeholder->id;
+        tex.thumbnailId = m_placeholder->id;
+        tex.ready = true;
+        return;
+    }
+
+    tex.id = m_uploader->upload(job.pixels, tex.width, tex.height);
+    tex.thumbnailId = uploadThumbnail(job.pixels, tex.width, tex.height, tex.id, *m_uploader);
+    tex.ready = true;
+    stbi_image_free(job.pixels);
+}
+
+void AssetMan::finishLoads(RedrawScheduler& redraw)
+{
+    if (m_decodeDone.valid())
+    {
+        if (m_decodeDone.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return;
+
+        PROFILE_ZONE("AssetMan::finishLoads");
+        ALLOC_SCOPE(AllocTag::ASSET_LOADING);
+        m_decodeDone.get();
+        for (DecodeJob& job : m_decoding) uploadDecoded(job);
+        m_decoding.clear();
+        m_revision++;
+        redraw.endJob();
+    }
+    if (m_queuedLoads.empty()) return;
+
+    ALLOC_SCOPE(AllocTag::ASSET_LOADING);
+    for (auto& tex : m_queuedLoads) m_decoding.push_back(DecodeJob{tex, nullptr});
+    m_queuedLoads.clear();
+
+    // A few threads, each grabbing the next image that's left
+    auto decodeAll = [this]() {
+        size_t threads = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), m_decoding.size());
+        std::atomic<size_t> nextJob{0};
+        auto work = [&]() {
+            for (size_t i = nextJob++; i < m_decoding.size(); i = nextJob++)
+            {
+                DecodeJob& job = m_decoding[i];
+                int width, height;
+                job.pixels = stbi_load(job.tex->filePath.u8string().c_str(), &width, &height, NULL, 4);
+
+                // Laid out at the size stbi_info() gave, which had better still be right
+                if (job.pixels && (width != job.tex->width || height != job.tex->height))
+                {
+                    stbi_image_free(job.pixels);
+                    job.pixels = nullptr;
+                }
+            }
+        };
+
+        std::vector<std::future<void>> helpers;
+        try
+        {
+            for (size_t i = 1; i < threads; i++) helpers.push_back(std::async(std::launch::async, work));
+        } catch (const std::system_error&)
+        {
+            // Fewer threads is fine, as long as get() in finishLoads() doesn't throw and leave the job open
+        }
+        work();
+        for (auto& helper : helpers) helper.get();
+    };
+    try
+    {
+        m_decodeDone = std::async(std::launch::async, decodeAll);
+    } catch (const std::system_error&)
+    {
+        // Couldn't start a thread, so these get another go on the next frame drawn
+        for (DecodeJob& job : m_decoding) m_queuedLoads.push_back(job.tex);
+        m_decoding.clear();
+        return;
+    }
+    // Only once it's running, or nothing would ever end the job
+    redraw.beginJob();
+}
+
+std::string AssetMan::takeLoadErrors()
+{
+    std::string errors;
+    errors.swap(m_loadErrors);
+    return errors;
+}
+
+AssetMan::~AssetMan()
+{
+    // Don't leave decode threads writing into a destroyed vector
+    if (!m_decodeDone.valid()) return;
+    m_decodeDone.wait();
+    for (DecodeJob& job : m_decoding) stbi_image_free(job.pixels);
+}
+
 std::shared_ptr<Texture> AssetMan::findTextureByShortName(const std::string& shortName)
 {
     auto it = std::find_if(m_textures.begin(), m_textures.end(), [&](auto tex) {
@@ -127,6 +288,22 @@ std::shared_ptr<Texture> AssetMan::findTextureByShortName(const std::string& sho
     return it != m_textures.end() ? *it : nullptr;
 }
 
+std::shared_ptr<Texture> AssetMan::createTexture(const unsigned char* rgbaPixels, int width, int height,
+                                                const std::string& shortName, bool withThumbnail)
+{
+    ALLOC_SCOPE(AllocTag::ASSET_LOADING);
+    auto tex = uploadTexture(rgbaPixels, width, height, *m_uploader, withThumbnail);
+    tex->shortName = shortName;
+    return tex;
+}
+
+void AssetMan::updateTexture(const Texture& tex, const unsigned char* rgbaPixels, int firstRow, int rows)
+{
+    // A separate thumbnail would go stale
+    if (tex.thumbnailId != tex.id) throw std::runtime_error("Can only update textures made without a thumbnail: " + tex.shortName);
+    m_uploader->update(tex.id, rgbaPixels + static_cast<size_t>(firstRow) * tex.width * 4, tex.width, firstRow, rows);
+}
+
 const std::vector<std::shared_ptr<Texture>>& AssetMan::getTextures()
 {
     return m_textures;
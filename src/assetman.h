@@ -1,35 +1,82 @@
 #pragma once
 
+#include "redrawscheduler.h"
+#include "textureuploader.h"
+
 #include <cstdint>
 #include <string>
 #include <memory>
 #include <filesystem>
+#include <future>
 #include <vector>
 
 struct Texture
 {
     void* id;
+    void* thumbnailId; // Same image scaled down to fit THUMBNAIL_SIZE, for drawing it tiny. Same as id if it's already small.
     int width;
     int height;
     std::filesystem::path filePath;
     std::string shortName;
+    bool ready = true; // False until a loadTextureAsync() upload lands, or its placeholder if decoding failed
 };
 
+constexpr int THUMBNAIL_SIZE = 64;
+
 class AssetMan
 {
 public:
     // Init function b/c assetman is allocated statically
     void init();
 
+    // Defaults to NullTextureUploader if never set, so headless tools can load assets without a GPU
+    void setUploader(std::unique_ptr<TextureUploader> uploader);
+
     std::shared_ptr<Texture> loadTexture(const std::filesystem::path& absPath, const std::string& shortName = "");
+    // Only reads the image size right away, so the texture can be laid out, and decodes it on background
+    // threads. finishLoads() uploads it later.
+    std::shared_ptr<Texture> loadTextureAsync(const std::filesystem::path& absPath, const std::string& shortName = "");
+    // Call every frame from the thread the uploader works on. Starts decoding whatever got queued and uploads
+    // whatever finished, with the decoding registered as a job so the main loop keeps drawing until it lands.
+    void finishLoads(RedrawScheduler& redraw);
+    // Goes up whenever async loads land, for anything holding on to texture ids
+    uint64_t revision() const { return m_revision; }
+    // What went wrong with async loads since the last call, one line per texture. Empty if nothing did.
+    std::string takeLoadErrors();
     std::shared_ptr<Texture> findTextureByShortName(const std::string& shortName);
+
+    // For textures generated at runtime. These aren't level assets, so they don't show up in getTextures().
+    // Textures that get updated should skip the thumbnail, whose thumbnailId is then just id.
+    std::shared_ptr<Texture> createTexture(const unsigned char* rgbaPixels, int width, int height,
+                                           const std::string& shortName, bool withThumbnail = true);
+    // Overwrites rows [firstRow, firstRow + rows) of a texture from createTexture(..., false). rgbaPixels is the
+    // whole image, only the band gets uploaded.
+    void updateTexture(const Texture& tex, const unsigned char* rgbaPixels, int firstRow, int rows);
     const std::vector<std::shared_ptr<Texture>>& getTextures();
 
 
     std::filesystem::path getAssetPathRoot();
     std::string getAssetPathStr(const std::filesystem::path& path);
 
+    ~AssetMan();
+
 private:
+    struct DecodeJob
+    {
+        std::shared_ptr<Texture> tex;
+        unsigned char* pixels; // From stbi_load, null if it failed
+    };
+
+    void uploadDecoded(DecodeJob& job);
+
     std::filesystem::path m_assetPathRoot;
     std::vector<std::shared_ptr<Texture>> m_textures;
+    std::unique_ptr<TextureUploader> m_uploader;
+
+    std::vector<std::shared_ptr<Texture>> m_queuedLoads;
+    std::vector<DecodeJob> m_decoding; // Only touched by the decode threads until m_decodeDone is ready
+    std::future<void> m_decodeDone;
+    uint64_t m_revision = 0;
+    std::string m_loadErrors;
+    std::shared_ptr<Texture> m_placeholder; // Stands in for textures that failed to decode
 };
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Copy-on-write holder. Copies share one T until somebody asks to write, at which point the writer gets its
+// own copy if anybody else still has the old one. Only ever write from the thread that makes the copies;
+// other threads can read their copies freely, since a shared T is never written to.
+template <typename T>
+class Cow
+{
+public:
+    Cow(): m_data{std::make_shared<T>()} {}
+
+    const T& get() const { return *m_data; }
+
+    T& mut()
+    {
+        if (m_data.use_count() > 1) m_data = std::make_shared<T>(*m_data);
+        else std::atomic_thread_fence(std::memory_order_acquire); // Pairs with other threads dropping their copies
+        return *m_data;
+    }
+
+private:
+    std::shared_ptr<T> m_data;
+};
+
+// Cow vector that indexes like the plain vector. Non-const indexing counts as a write, so read through a
+// const reference in loops where that matters.
+template <typename T>
+class CowColumn: public Cow<std::vector<T>>
+{
+public:
+    const T& operator[](size_t i) const { return this->get()[i]; }
+    T& operator[](size_t i) { return this->mut()[i]; }
+
+    size_t size() const { return this->get().size(); }
+};
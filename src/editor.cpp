@@ -1,6 +1,9 @@
+#include "editor.h"
+#include "alloctracker.h"
 #include "assetman.h"
 #include "loadjson.h"
-#include "util.h"
+#include "profiler.h"
+#include "profilerview.h"
 #include "visualizer.h"
 #include "recipeeditor.h"
 #include "global.h"
@@ -9,38 +12,55 @@
 #include "imgui.h"
 #include "imfilebrowser.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <future>
+#include <vector>
+
 namespace fs = std::filesystem;
 
 static ImGui::FileBrowser s_fileDialog;
+static std::future<void> s_pendingSave;
 
 const static ImVec4 FAKE_HEADER_COLOR(0.4f, 0.4f, 1.0f, 1.0f);
 
-static void openLevelJson(const std::string& jsonFilename)
+void openLevelJson(const std::string& jsonFilename)
 {
     g_jsonFilename = jsonFilename;
     g_level = loadJsonLevel(jsonFilename);
+    g_levelIndex.rebuild(g_level);
+    g_undo.clear();
 
     // Initially center on the start planet
     // Or else the initial position is (0, 0) I guess
-    for (auto& planet : g_level->planets)
+    const LevelObjects& objects = g_level->objects;
+    for (size_t row = 0; row < objects.size(); row++)
     {
-        if (planet->order == PlanetOrder::START)
+        if (objects.kind[row] == ObjectKind::PLANET && objects.planetOrder[row] == PlanetOrder::START)
         {
-            g_viz.setWorldPos(planet->pos);
-            g_selectedObj = planet;
+            g_viz.setWorldPos(objects.pos[row]);
+            g_selection.selectOnly(objects.idAt(row));
         }
     }
 }
 
-static std::string getFileSelection(const std::string& button, const std::string& windowTitle, const std::filesystem::path& path)
+void replayLevelLoad(const std::string& levelPath, const std::shared_ptr<LevelModel>& levelBeforeFrame)
+{
+    if (levelPath.empty()) return;
+    if (g_level == levelBeforeFrame || g_jsonFilename != levelPath) openLevelJson(levelPath);
+}
+
+// Starts browsing in assetDir under the asset root
+static std::string getFileSelection(const char* button, const char* windowTitle, const char* assetDir)
 {
     // Hackily use the button text as the ID of the file type being selected
     static std::string id;
 
-    if (ImGui::Button(button.c_str()))
+    if (ImGui::Button(button))
     {
         s_fileDialog.SetTitle(windowTitle);
-        s_fileDialog.SetPwd(path);
+        s_fileDialog.SetPwd(g_assetMan.getAssetPathRoot() / assetDir);
         s_fileDialog.Open();
         id = button;
     }
@@ -57,12 +77,27 @@ static std::string getFileSelection(const std::string& button, const std::string
     return "";
 }
 
+static void startBackgroundSave()
+{
+    validateLevelForExport(*g_level);
+    saveAssetsJson();
+
+    // The level file gets written from a snapshot, so editing can carry on in the meantime
+    auto snapshot = std::make_shared<const LevelModel>(*g_level);
+    g_redraw.beginJob();
+    s_pendingSave = std::async(std::launch::async, [snapshot, filename = g_jsonFilename]() {
+        struct EndJob { ~EndJob() { g_redraw.endJob(); } } endJob;
+        saveLevelJson(filename, *snapshot);
+    });
+}
+
 static void showJsonFileState()
 {
     if (g_level)
     {
-        std::string file = std::filesystem::path(g_jsonFilename).filename().string();
-        ImGui::TextColored(FAKE_HEADER_COLOR, "JSON loaded: %s", file.c_str());
+        // Just the file name, without building a path every frame
+        const char* file = g_jsonFilename.c_str() + (g_jsonFilename.find_last_of("/\\") + 1);
+        ImGui::TextColored(FAKE_HEADER_COLOR, "JSON loaded: %s", file);
     } else
     {
         ImGui::TextColored(FAKE_HEADER_COLOR, "No JSON file loaded");
@@ -70,8 +105,7 @@ static void showJsonFileState()
 
     static std::string openErrorMsg;
 
-    std::filesystem::path defaultJsonPath = g_assetMan.getAssetPathRoot() / "json";
-    std::string levelJsonPath = getFileSelection("Open", "Open JSON Level", defaultJsonPath);
+    std::string levelJsonPath = getFileSelection("Open", "Open JSON Level", "json");
     if (levelJsonPath.size() != 0)
     {
         try
@@ -84,6 +118,15 @@ static void showJsonFileState()
         }
     }
 
+    // Textures finish loading after the level opens (see AssetMan::loadTextureAsync()), and the ones that
+    // don't are drawn as placeholders
+    std::string textureErrors = g_assetMan.takeLoadErrors();
+    if (!textureErrors.empty())
+    {
+        openErrorMsg = textureErrors;
+        ImGui::OpenPopup("Cannot open level");
+    }
+
     if (ImGui::BeginPopupModal("Cannot open level"))
     {
         ImGui::Text("Cannot open level: %s", openErrorMsg.c_str());
@@ -96,11 +139,27 @@ static void showJsonFileState()
     if (g_level)
     {
         ImGui::SameLine();
-        if (ImGui::Button("Save"))
+        if (s_pendingSave.valid())
+        {
+            ImGui::Text("Saving...");
+        }
+        else if (ImGui::Button("Save"))
+        {
+            try
+            {
+                startBackgroundSave();
+            } catch (const std::exception& ex)
+            {
+                ImGui::OpenPopup("Cannot save level");
+                saveErrorMsg = ex.what();
+            }
+        }
+
+        if (s_pendingSave.valid() && s_pendingSave.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
         {
             try
             {
-                saveJsonLevel(g_jsonFilename, g_level);
+                s_pendingSave.get();
             } catch (const std::exception& ex)
             {
                 ImGui::OpenPopup("Cannot save level");
@@ -143,82 +202,116 @@ static void showLevelProperties()
     ImGui::InputInt("Level number", &g_level->levelNumber);
     ImGui::InputFloat("Level timer", &g_level->levelTimer);
 
-    fs::path texDirPath = g_assetMan.getAssetPathRoot() / "textures";
+    if (ImGui::Button("Undo")) g_undo.undo(*g_level, g_levelIndex);
+    ImGui::SameLine();
+    if (ImGui::Button("Redo")) g_undo.redo(*g_level, g_levelIndex);
 
     // Add planet button
-    std::filesystem::path texPath = getFileSelection("Add planet", "Select planet texture", texDirPath);
+    std::filesystem::path texPath = getFileSelection("Add planet", "Select planet texture", "textures");
     if (!texPath.empty())
     {
-        auto planet = std::make_shared<PlanetModel>();
-        planet->tex = g_assetMan.loadTexture(texPath);
-        planet->pos = g_viz.getWorldPos();
-        planet->anchor = ImVec2(0.5, 0.5);
-        planet->scale = 0.5;
-        planet->cols = 2;
-        planet->span = 2;
-        planet->type = PlanetType::NORMAL;
-        planet->hasFood = false;
-        planet->order = PlanetOrder::MIDDLE;
-
-        g_level->planets.emplace_back(planet);
-        g_selectedObj = planet;
+        LevelObjects& objects = g_level->objects;
+        ObjectId planet = objects.add(ObjectKind::PLANET, g_assetMan.loadTexture(texPath));
+        size_t row = objects.rowOf(planet);
+        objects.pos[row] = g_viz.getWorldPos();
+        objects.scale[row] = 0.5;
+        objects.cols[row] = 2;
+        objects.span[row] = 2;
+        objects.planetType[row] = PlanetType::NORMAL;
+        objects.planetOrder[row] = PlanetOrder::MIDDLE;
+
+        g_undo.recordAdd(objects, planet);
+        g_levelIndex.insert(planet);
+        g_selection.selectOnly(planet);
     }
     ImGui::SameLine();
 
     // Add food button
-    texPath = getFileSelection("Add food", "Select food texture", texDirPath);
+    texPath = getFileSelection("Add food", "Select food texture", "textures");
     if (!texPath.empty())
     {
-        auto food = std::make_shared<FoodModel>();
-        food->tex = g_assetMan.loadTexture(texPath);
-        food->pos = g_viz.getWorldPos();
-        food->anchor = ImVec2(0.5, 0.5);
-        food->scale = 0.5;
-        food->cols = 1;
-        food->span = 1;
-        food->cookable = false;
-        food->seasonable = false;
-
-        g_level->foods.emplace_back(food);
-        g_selectedObj = food;
+        LevelObjects& objects = g_level->objects;
+        ObjectId food = objects.add(ObjectKind::FOOD, g_assetMan.loadTexture(texPath));
+        size_t row = objects.rowOf(food);
+        objects.pos[row] = g_viz.getWorldPos();
+        objects.scale[row] = 0.5;
+
+        g_undo.recordAdd(objects, food);
+        g_levelIndex.insert(food);
+        g_selection.selectOnly(food);
     }
     ImGui::SameLine();
 
     // Add player button
-    texPath = getFileSelection("Add player", "Select player texture", texDirPath);
+    texPath = getFileSelection("Add player", "Select player texture", "textures");
     if (!texPath.empty())
     {
-        auto player = std::make_shared<ObjectModel>();
-        player->tex = g_assetMan.loadTexture(texPath);
-        player->pos = g_viz.getWorldPos();
-        player->anchor = ImVec2(0.5, 0.5);
-        player->scale = 0.5;
-        player->cols = 1;
-        player->span = 1;
-
+        LevelObjects& objects = g_level->objects;
+        ObjectId player = objects.add(ObjectKind::PLAYER, g_assetMan.loadTexture(texPath));
+        size_t row = objects.rowOf(player);
+        objects.pos[row] = g_viz.getWorldPos();
+        objects.scale[row] = 0.5;
+
+        g_undo.recordAdd(objects, player);
+        g_undo.recordRemove(objects, g_level->player);
+        g_levelIndex.remove(g_level->player);
+        objects.remove(g_level->player);
         g_level->player = player;
-        g_selectedObj = player;
+        g_levelIndex.insert(player);
+        g_selection.selectOnly(player);
     }
     ImGui::SameLine();
 
-    texPath = getFileSelection("Add customer", "Select player texture", texDirPath);
+    texPath = getFileSelection("Add customer", "Select player texture", "textures");
     if (!texPath.empty())
     {
-        auto customer = std::make_shared<ObjectModel>();
-        customer->tex = g_assetMan.loadTexture(texPath);
-        customer->pos = g_viz.getWorldPos();
-        customer->anchor = ImVec2(0.5, 0.5);
-        customer->scale = 0.5;
-        customer->cols = 1;
-        customer->span = 1;
-
+        LevelObjects& objects = g_level->objects;
+        ObjectId customer = objects.add(ObjectKind::CUSTOMER, g_assetMan.loadTexture(texPath));
+        size_t row = objects.rowOf(customer);
+        objects.pos[row] = g_viz.getWorldPos();
+        objects.scale[row] = 0.5;
+
+        g_undo.recordAdd(objects, customer);
+        g_undo.recordRemove(objects, g_level->customer);
+        g_levelIndex.remove(g_level->customer);
+        objects.remove(g_level->customer);
         g_level->customer = customer;
-        g_selectedObj = customer;
+        g_levelIndex.insert(customer);
+        g_selection.selectOnly(customer);
     }
 }
 
+// Offset for duplicates, so they don't land exactly on top of what they're copies of
+static ImVec2 duplicateOffset()
+{
+    constexpr float OFFSET_PX = 30;
+    return ImVec2(OFFSET_PX / g_viz.getZoom(), OFFSET_PX / g_viz.getZoom());
+}
+
+// Batch edits for when more than one object is selected
+static void showSelectionEditor()
+{
+    LevelObjects& objects = g_level->objects;
+    ImGui::Text("%zu objects selected", g_selection.size());
+
+    static ImVec2 s_moveBy(0, 0);
+    ImGui::InputFloat2("##moveBy", &s_moveBy.x, "%.1f");
+    ImGui::SameLine();
+    if (ImGui::Button("Move by")) moveSelection(objects, g_levelIndex, g_undo, g_selection, s_moveBy);
+
+    static float s_scaleBy = 1;
+    ImGui::InputFloat("##scaleBy", &s_scaleBy, 0.1f, 0.5f, "%.2f");
+    ImGui::SameLine();
+    if (ImGui::Button("Scale by") && s_scaleBy > 0) scaleSelection(objects, g_levelIndex, g_undo, g_selection, s_scaleBy);
+
+    if (ImGui::Button("Duplicate")) duplicateSelection(objects, g_levelIndex, g_undo, g_selection, duplicateOffset());
+    ImGui::SameLine();
+    if (showRedButton("Delete objects")) deleteSelection(objects, g_levelIndex, g_undo, g_selection);
+}
+
 static void showPropertiesEditor()
 {
+    ALLOC_SCOPE(AllocTag::PROPERTIES);
     ImGui::Begin("Properties Editor");
 
     showJsonFileState();
@@ -228,102 +321,259 @@ static void showPropertiesEditor()
     ImGui::Separator();
 
     ImGui::TextColored(FAKE_HEADER_COLOR, "Object Properties");
-    if (!g_selectedObj)
+    LevelObjects* objects = g_level ? &g_level->objects : nullptr;
+    if (objects) g_selection.removeMissing(*objects);
+    if (!objects || g_selection.empty())
     {
         ImGui::Text("No selected object");
         ImGui::End();
         return;
     }
+    if (g_selection.size() > 1)
+    {
+        showSelectionEditor();
+        ImGui::End();
+        return;
+    }
+
+    ObjectId selectedObj = g_selection.primary();
+    size_t row = objects->rowOf(selectedObj);
+    ObjectRecord before = objects->record(selectedObj);
+
+    // The widgets edit copies, and a column only gets written when one actually changes. Writing copies the whole
+    // column while a background save still holds the old one (see Cow).
+    const LevelObjects& view = *objects;
+    ImVec2 pos = view.pos[row];
+    ImVec2 anchor = view.anchor[row];
+    float scale = view.scale[row];
+    int cols = view.cols[row];
+    int span = view.span[row];
+    unsigned int flags = view.flags[row];
 
     // Is casting like this bad?
-    ImGui::InputFloat2("Position", reinterpret_cast<float *>(&g_selectedObj->pos), "%.3f");
-    ImGui::InputFloat2("Anchor", reinterpret_cast<float *>(&g_selectedObj->anchor), "%.3f");
-    ImGui::SliderFloat("Scale", &g_selectedObj->scale, 0.1, 2.0);
+    bool boundsChanged = false;
+    if (ImGui::InputFloat2("Position", reinterpret_cast<float *>(&pos), "%.3f"))
+    {
+        objects->pos[row] = pos;
+        boundsChanged = true;
+    }
+    if (ImGui::InputFloat2("Anchor", reinterpret_cast<float *>(&anchor), "%.3f")) objects->anchor[row] = anchor;
+    if (ImGui::SliderFloat("Scale", &scale, 0.1, 2.0))
+    {
+        objects->scale[row] = scale;
+        boundsChanged = true;
+    }
+
+    if (ImGui::InputInt("Texture columns", &cols))
+    {
+        objects->cols[row] = cols;
+        boundsChanged = true;
+    }
+    if (ImGui::InputInt("Texture span", &span))
+    {
+        objects->span[row] = span;
+        boundsChanged = true;
+    }
 
-    ImGui::InputInt("Texture columns", &g_selectedObj->cols);
-    ImGui::InputInt("Texture span", &g_selectedObj->span);
+    if (boundsChanged) g_levelIndex.update(selectedObj);
 
     // Handle object deletion
-    if (g_selectedObj && showRedButton("Delete object"))
+    if (showRedButton("Delete object"))
     {
-        if (g_selectedObj == g_level->player) g_level->player = nullptr;
-        else if (g_selectedObj == g_level->customer) g_level->customer = nullptr;
-        else
-        {
-            auto& planets = g_level->planets;
-            auto& foods = g_level->foods;
-            planets.erase(std::remove(planets.begin(), planets.end(), g_selectedObj), planets.end());
-            foods.erase(std::remove(foods.begin(), foods.end(), g_selectedObj), foods.end());
-        }
+        g_undo.recordChanges(*objects, before);
+        g_undo.recordRemove(*objects, selectedObj);
+        g_levelIndex.remove(selectedObj);
+        objects->remove(selectedObj);
+        g_selection.clear();
 
-        g_selectedObj = nullptr;
+        ImGui::End();
+        return;
     }
 
     ImGui::Separator();
 
-    // Show planet-specific properties if this is a planet
-    auto selectedPlanet = std::dynamic_pointer_cast<PlanetModel>(g_selectedObj);
-    if (selectedPlanet)
+    switch (view.kind[row])
+    {
+    case ObjectKind::PLANET:
     {
         ImGui::TextColored(FAKE_HEADER_COLOR, "Planet Properties");
 
-        int order = static_cast<int>(selectedPlanet->order);
-        ImGui::RadioButton("Start planet", &order, 0);
+        int order = static_cast<int>(view.planetOrder[row]);
+        bool orderChanged = false;
+        orderChanged |= ImGui::RadioButton("Start planet", &order, 0);
         ImGui::SameLine();
-        ImGui::RadioButton("Middle planet", &order, 1);
+        orderChanged |= ImGui::RadioButton("Middle planet", &order, 1);
         ImGui::SameLine();
-        ImGui::RadioButton("End planet", &order, 2);
-        selectedPlanet->order = static_cast<PlanetOrder>(order);
+        orderChanged |= ImGui::RadioButton("End planet", &order, 2);
+        if (orderChanged) objects->planetOrder[row] = static_cast<PlanetOrder>(order);
 
-        int type = static_cast<int>(selectedPlanet->type);
-        ImGui::RadioButton("Normal", &type, 0);
+        int type = static_cast<int>(view.planetType[row]);
+        bool typeChanged = false;
+        typeChanged |= ImGui::RadioButton("Normal", &type, 0);
         ImGui::SameLine();
-        ImGui::RadioButton("Sun", &type, 1);
+        typeChanged |= ImGui::RadioButton("Sun", &type, 1);
         ImGui::SameLine();
-        ImGui::RadioButton("Blackhole", &type, 2);
+        typeChanged |= ImGui::RadioButton("Blackhole", &type, 2);
         ImGui::SameLine();
-        ImGui::RadioButton("Storage", &type, 3);
+        typeChanged |= ImGui::RadioButton("Storage", &type, 3);
         ImGui::SameLine();
-        ImGui::RadioButton("Season", &type, 4);
-        selectedPlanet->type = static_cast<PlanetType>(type);
+        typeChanged |= ImGui::RadioButton("Season", &type, 4);
+        if (typeChanged) objects->planetType[row] = static_cast<PlanetType>(type);
 
-        ImGui::Checkbox("Has food", &selectedPlanet->hasFood);
+        if (ImGui::CheckboxFlags("Has food", &flags, OBJECT_HAS_FOOD)) objects->flags[row] = flags;
+        break;
     }
-
-    // Show food-specific properties if this is a food
-    auto selectedFood = std::dynamic_pointer_cast<FoodModel>(g_selectedObj);
-    if (selectedFood)
+    case ObjectKind::FOOD:
     {
         ImGui::TextColored(FAKE_HEADER_COLOR, "Food Properties");
-        ImGui::Checkbox("Cookable", &selectedFood->cookable);
-        ImGui::Checkbox("Seasonable", &selectedFood->seasonable);
+        bool flagsChanged = false;
+        flagsChanged |= ImGui::CheckboxFlags("Cookable", &flags, OBJECT_COOKABLE);
+        flagsChanged |= ImGui::CheckboxFlags("Seasonable", &flags, OBJECT_SEASONABLE);
+        if (flagsChanged) objects->flags[row] = flags;
+        break;
     }
-
-    if (g_selectedObj == g_level->player)
-    {
+    case ObjectKind::PLAYER:
         ImGui::TextColored(FAKE_HEADER_COLOR, "Player properties");
+        break;
+    case ObjectKind::CUSTOMER:
+        ImGui::TextColored(FAKE_HEADER_COLOR, "Customer properties");
+        break;
     }
 
-    if (g_selectedObj == g_level->customer)
+    g_undo.recordChanges(*objects, before);
+
+    ImGui::End();
+}
+
+// Stand-in for gravity ranges when zoomed far out, just an antialiased ring
+static std::shared_ptr<Texture> makeRangeOutlineTexture()
+{
+    constexpr int SIZE = 64;
+    constexpr float LINE_WIDTH = 3.f;
+
+    std::vector<unsigned char> pixels(SIZE * SIZE * 4);
+    for (int y = 0; y < SIZE; y++)
     {
-        ImGui::TextColored(FAKE_HEADER_COLOR, "Customer properties");
+        for (int x = 0; x < SIZE; x++)
+        {
+            float dx = x + 0.5f - SIZE / 2.f;
+            float dy = y + 0.5f - SIZE / 2.f;
+            float distFromLine = std::abs(std::sqrt(dx * dx + dy * dy) - (SIZE / 2.f - LINE_WIDTH / 2 - 1));
+            float coverage = std::min(std::max(LINE_WIDTH / 2 + 0.5f - distFromLine, 0.f), 1.f);
+
+            unsigned char* px = &pixels[(y * SIZE + x) * 4];
+            px[0] = px[1] = px[2] = 255;
+            px[3] = static_cast<unsigned char>(coverage * 160);
+        }
     }
 
-    ImGui::End();
+    return g_assetMan.createTexture(pixels.data(), SIZE, SIZE, "range outline");
 }
 
 void initEditor()
 {
     g_assetMan.init();
     g_gravRangeTex = g_assetMan.loadTexture(g_assetMan.getAssetPathRoot() / "textures" / "range.png", "range");
+    g_gravRangeOutlineTex = makeRangeOutlineTexture();
     g_showGravRanges = true;
     s_fileDialog.SetTitle("Select file");
 }
 
+// Delete and Ctrl+D, for everything selected
+static void handleSelectionShortcuts()
+{
+    ImGuiIO& io = ImGui::GetIO();
+    if (!g_level || g_selection.empty() || io.WantTextInput) return;
+
+    if (ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_Delete), false))
+    {
+        deleteSelection(g_level->objects, g_levelIndex, g_undo, g_selection);
+    }
+    else if (io.KeyCtrl && ImGui::IsKeyPressed('D', false))
+    {
+        duplicateSelection(g_level->objects, g_levelIndex, g_undo, g_selection, duplicateOffset());
+    }
+}
+
+static void handleUndoShortcuts()
+{
+    ImGuiIO& io = ImGui::GetIO();
+    if (!g_level || !io.KeyCtrl || io.WantTextInput) return;
+
+    // Ctrl+Z, and both Ctrl+Shift+Z and Ctrl+Y to redo
+    if (ImGui::IsKeyPressed('Z', false))
+    {
+        if (io.KeyShift) g_undo.redo(*g_level, g_levelIndex);
+        else g_undo.undo(*g_level, g_levelIndex);
+    }
+    else if (ImGui::IsKeyPressed('Y', false))
+    {
+        g_undo.redo(*g_level, g_levelIndex);
+    }
+}
+
+#ifdef MWG_ALLOC_TRACKING
+// Counts from the previous frame, i.e. between the last two calls to this
+static void showAllocTracker()
+{
+    static AllocStats s_frameStart = allocStatsSnapshot();
+    AllocStats total = allocStatsSnapshot();
+    AllocStats frame = total - s_frameStart;
+    s_frameStart = total;
+
+    ImGui::SetNextWindowSize(ImVec2(520, 220), ImGuiCond_FirstUseEver);
+    ImGui::Begin("Allocations");
+
+    ImGui::Columns(5, "allocs");
+    for (const char* header : {"", "last frame", "bytes", "total", "bytes"})
+    {
+        ImGui::TextColored(FAKE_HEADER_COLOR, "%s", header);
+        ImGui::NextColumn();
+    }
+    ImGui::Separator();
+
+    auto showRow = [](const char* name, AllocCounter frameCounter, AllocCounter totalCounter) {
+        ImGui::Text("%s", name);
+        ImGui::NextColumn();
+        ImGui::Text("%llu", static_cast<unsigned long long>(frameCounter.count));
+        ImGui::NextColumn();
+        ImGui::Text("%llu", static_cast<unsigned long long>(frameCounter.bytes));
+        ImGui::NextColumn();
+        ImGui::Text("%llu", static_cast<unsigned long long>(totalCounter.count));
+        ImGui::NextColumn();
+        ImGui::Text("%llu", static_cast<unsigned long long>(totalCounter.bytes));
+        ImGui::NextColumn();
+    };
+    for (size_t i = 0; i < ALLOC_TAG_COUNT; i++)
+    {
+        showRow(allocTagName(static_cast<AllocTag>(i)), frame.tags[i], total.tags[i]);
+    }
+    ImGui::Separator();
+    showRow("all", frame.total(), total.total());
+
+    ImGui::Columns(1);
+    ImGui::End();
+}
+#endif
+
 void runEditor()
 {
+    PROFILE_ZONE("runEditor");
 //    ImGui::ShowDemoWindow();
+    g_frameArena.reset();
+    g_assetMan.finishLoads(g_redraw);
+#ifdef MWG_ALLOC_TRACKING
+    showAllocTracker();
+#endif
+#ifdef MWG_PROFILER
+    showProfilerWindow();
+#endif
+    handleUndoShortcuts();
+    handleSelectionShortcuts();
     showLevelVisualizer();
     showPropertiesEditor();
     showRecipeEditor();
+
+    // Drags and slider tweaks keep going into the same undo step until they're let go of
+    if (!ImGui::IsAnyItemActive()) g_undo.endStep();
 }
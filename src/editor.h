@@ -1,4 +1,14 @@
 #pragma once
 
+#include "levelmodel.h"
+
+#include <memory>
+#include <string>
+
 void initEditor();
-void runEditor();
\ No newline at end of file
+void runEditor();
+
+void openLevelJson(const std::string& jsonFilename);
+
+// During input replay the recorded level loads are authoritative, since file dialogs don't replay reliably
+void replayLevelLoad(const std::string& levelPath, const std::shared_ptr<LevelModel>& levelBeforeFrame);
\ No newline at end of file
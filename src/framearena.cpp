@@ -0,0 +1,36 @@
+#include "framearena.h"
+
+#include <algorithm>
+#include <cstdint>
+
+FrameArena::FrameArena(size_t initialSize):
+    m_block{std::make_unique<unsigned char[]>(initialSize)}, m_blockSize{initialSize} {}
+
+void* FrameArena::allocate(size_t size, size_t align)
+{
+    auto base = reinterpret_cast<uintptr_t>(m_block.get());
+    size_t start = ((base + m_offset + align - 1) & ~(align - 1)) - base;
+    if (start + size <= m_blockSize)
+    {
+        m_offset = start + size;
+        return m_block.get() + start;
+    }
+
+    // Out of room this frame, reset() will make the block big enough next time
+    m_overflow.push_back(std::make_unique<unsigned char[]>(size + align));
+    m_overflowBytes += size + align;
+    auto overflowBase = reinterpret_cast<uintptr_t>(m_overflow.back().get());
+    return reinterpret_cast<void*>((overflowBase + align - 1) & ~(align - 1));
+}
+
+void FrameArena::reset()
+{
+    if (!m_overflow.empty())
+    {
+        m_blockSize = std::max(m_blockSize * 2, m_offset + m_overflowBytes);
+        m_block = std::make_unique<unsigned char[]>(m_blockSize);
+        m_overflow.clear();
+        m_overflowBytes = 0;
+    }
+    m_offset = 0;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Bump allocator for data that only has to last until the end of the frame, reset at the top of every frame.
+// Everything comes out of one block that's reused from frame to frame. A frame that needs more than that gets
+// overflow allocations, and the next reset() swaps them all for one bigger block, so after a few frames
+// nothing here touches the heap anymore.
+class FrameArena
+{
+public:
+    explicit FrameArena(size_t initialSize = 64 * 1024);
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void* allocate(size_t size, size_t align);
+    void reset();
+
+    size_t bytesUsed() const { return m_offset + m_overflowBytes; }
+    size_t capacity() const { return m_blockSize; }
+
+private:
+    std::unique_ptr<unsigned char[]> m_block;
+    size_t m_blockSize;
+    size_t m_offset = 0;
+
+    std::vector<std::unique_ptr<unsigned char[]>> m_overflow;
+    size_t m_overflowBytes = 0;
+};
+
+// Lets standard containers live in a FrameArena. Memory is only given back by FrameArena::reset(), so reserve()
+// up front where possible instead of letting containers grow.
+template <typename T>
+class ArenaAllocator
+{
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(FrameArena& arena): m_arena{&arena} {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other): m_arena{other.m_arena} {}
+
+    T* allocate(size_t count) { return static_cast<T*>(m_arena->allocate(count * sizeof(T), alignof(T))); }
+    void deallocate(T*, size_t) {}
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const { return m_arena == other.m_arena; }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return m_arena != other.m_arena; }
+
+private:
+    template <typename U>
+    friend class ArenaAllocator;
+
+    FrameArena* m_arena;
+};
+
+template <typename T>
+using FrameVector = std::vector<T, ArenaAllocator<T>>;
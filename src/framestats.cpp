@@ -0,0 +1,146 @@
+#include "framestats.h"
+#include "visualizer.h"
+
+#include "imgui.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+RenderCounters g_renderCounters;
+static FrameStatsHistory s_history;
+
+void FrameStatsHistory::push(const FrameStats& stats)
+{
+    m_frames[m_next] = stats;
+    m_buildMs[m_next] = static_cast<float>(stats.buildMs);
+    m_next = (m_next + 1) % HISTORY_SIZE;
+    m_count = std::min(m_count + 1, HISTORY_SIZE);
+}
+
+float FrameStatsHistory::buildMsPercentile(float p) const
+{
+    if (m_count == 0) return 0;
+    float sorted[HISTORY_SIZE];
+    std::copy(m_buildMs, m_buildMs + m_count, sorted);
+    float* nth = sorted + static_cast<int>(p * (m_count - 1) + 0.5f);
+    std::nth_element(sorted, nth, sorted + m_count);
+    return *nth;
+}
+
+const FrameStatsHistory& recentFrameStats()
+{
+    return s_history;
+}
+
+FrameStats buildMeasuredFrame(void (*buildUi)())
+{
+    g_renderCounters = RenderCounters{};
+    auto start = std::chrono::steady_clock::now();
+
+    ImGui::NewFrame();
+    buildUi();
+    ImGui::Render();
+
+    auto end = std::chrono::steady_clock::now();
+
+    FrameStats stats{};
+    stats.buildMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+    ImDrawData* drawData = ImGui::GetDrawData();
+    stats.vtxCount = drawData->TotalVtxCount;
+    stats.idxCount = drawData->TotalIdxCount;
+    stats.textureBinds = g_renderCounters.textureBinds;
+    for (int i = 0; i < drawData->CmdListsCount; i++)
+    {
+        const ImVector<ImDrawCmd>& cmds = drawData->CmdLists[i]->CmdBuffer;
+        stats.drawCmds += cmds.Size;
+        for (const ImDrawCmd& cmd : cmds)
+        {
+            if (!cmd.UserCallback) stats.textureBinds++;
+        }
+    }
+
+    // ImGui's backend streams every vertex and index up again each frame
+    stats.bytesUploaded = g_renderCounters.bytesUploaded + drawData->TotalVtxCount * sizeof(ImDrawVert) +
+                          drawData->TotalIdxCount * sizeof(ImDrawIdx);
+
+    stats.objectsDrawn = getVisualizerStats().objectsDrawn;
+    stats.objectsCulled = getVisualizerStats().objectsCulled;
+
+    s_history.push(stats);
+
+    return stats;
+}
+
+double percentile(std::vector<double> values, double p)
+{
+    if (values.empty()) return 0;
+    std::sort(values.begin(), values.end());
+    return values[static_cast<size_t>(p * (values.size() - 1) + 0.5)];
+}
+
+template <typename F>
+static void printStatRow(const char* name, const std::vector<FrameStats>& stats, F getValue)
+{
+    std::vector<double> values;
+    values.reserve(stats.size());
+    for (auto& s : stats) values.push_back(getValue(s));
+
+    double mean = 0;
+    for (double v : values) mean += v;
+    if (!values.empty()) mean /= values.size();
+
+    printf("%-18s %12.3f %12.3f %12.3f %12.3f\n", name,
+           percentile(values, 0.5), percentile(values, 0.99), mean, percentile(values, 1.0));
+}
+
+void printFrameStatsSummary(const std::vector<FrameStats>& stats)
+{
+    printf("%-18s %12s %12s %12s %12s\n", "", "p50", "p99", "mean", "max");
+    printStatRow("frame build (ms)", stats, [](const FrameStats& s) { return s.buildMs; });
+    printStatRow("vertices", stats, [](const FrameStats& s) { return s.vtxCount; });
+    printStatRow("indices", stats, [](const FrameStats& s) { return s.idxCount; });
+    printStatRow("draw cmds", stats, [](const FrameStats& s) { return s.drawCmds; });
+    printStatRow("objects drawn", stats, [](const FrameStats& s) { return s.objectsDrawn; });
+    printStatRow("objects culled", stats, [](const FrameStats& s) { return s.objectsCulled; });
+    printStatRow("texture binds", stats, [](const FrameStats& s) { return s.textureBinds; });
+    printStatRow("KB uploaded", stats, [](const FrameStats& s) { return s.bytesUploaded / 1024.0; });
+}
+
+void saveFrameStatsCsv(const std::string& filename, const std::vector<FrameStats>& stats)
+{
+    std::ofstream csv(filename);
+    if (!csv) throw std::runtime_error("Could not write frame stats: " + filename);
+
+    csv << "frame,build_ms,vertices,indices,draw_cmds,objects_drawn,objects_culled,texture_binds,bytes_uploaded\n";
+    for (size_t i = 0; i < stats.size(); i++)
+    {
+        csv << i << ',' << stats[i].buildMs << ',' << stats[i].vtxCount << ','
+            << stats[i].idxCount << ',' << stats[i].drawCmds << ','
+            << stats[i].objectsDrawn << ',' << stats[i].objectsCulled << ','
+            << stats[i].textureBinds << ',' << stats[i].bytesUploaded << '\n';
+    }
+}
+
+CpuUsageMeter::CpuUsageMeter(): m_lastCpu{std::clock()}, m_lastWall{std::chrono::steady_clock::now()} {}
+
+double CpuUsageMeter::secondsSinceSample() const
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_lastWall).count();
+}
+
+double CpuUsageMeter::sample()
+{
+    std::clock_t cpu = std::clock();
+    auto wall = std::chrono::steady_clock::now();
+
+    double cpuSeconds = static_cast<double>(cpu - m_lastCpu) / CLOCKS_PER_SEC;
+    double wallSeconds = std::chrono::duration<double>(wall - m_lastWall).count();
+    m_lastCpu = cpu;
+    m_lastWall = wall;
+
+    return wallSeconds > 0 ? cpuSeconds / wallSeconds * 100 : 0;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <chrono>
+#include <ctime>
+#include <string>
+#include <vector>
+
+struct FrameStats
+{
+    double buildMs; // CPU time from ImGui::NewFrame() through ImGui::Render()
+    int vtxCount;
+    int idxCount;
+    int drawCmds;
+    int objectsDrawn;
+    int objectsCulled;
+    int textureBinds; // Including the one ImGui's backend does for every draw command
+    size_t bytesUploaded; // Vertex/index/instance buffers and textures
+};
+
+// GPU work the renderers have queued up for the frame being built, which buildMeasuredFrame() adds to
+// ImGui's own from the draw data. Anything that binds a texture or uploads to the GPU outside of ImGui's
+// draw lists should add to these.
+struct RenderCounters
+{
+    int textureBinds;
+    size_t bytesUploaded;
+};
+
+extern RenderCounters g_renderCounters;
+
+// The last HISTORY_SIZE frames from buildMeasuredFrame(), oldest first starting at offset()
+class FrameStatsHistory
+{
+public:
+    static constexpr int HISTORY_SIZE = 240;
+
+    void push(const FrameStats& stats);
+
+    int size() const { return m_count; }
+    int offset() const { return m_count < HISTORY_SIZE ? 0 : m_next; }
+    const FrameStats& latest() const { return m_frames[(m_next + HISTORY_SIZE - 1) % HISTORY_SIZE]; }
+    const float* buildMs() const { return m_buildMs; } // Ring buffer, for ImGui::PlotLines()
+
+    // Of the build times in the history, without allocating
+    float buildMsPercentile(float p) const;
+
+private:
+    FrameStats m_frames[HISTORY_SIZE] = {};
+    float m_buildMs[HISTORY_SIZE] = {};
+    int m_next = 0;
+    int m_count = 0;
+};
+
+const FrameStatsHistory& recentFrameStats();
+
+// Runs one ImGui frame around buildUi, timing it and measuring the draw data it produced
+FrameStats buildMeasuredFrame(void (*buildUi)());
+
+double percentile(std::vector<double> values, double p);
+
+void printFrameStatsSummary(const std::vector<FrameStats>& stats);
+void saveFrameStatsCsv(const std::string& filename, const std::vector<FrameStats>& stats);
+
+// CPU time this process used between calls to sample(), as a percentage of one core. Mostly for checking that
+// the editor really does nothing while it's sitting idle.
+class CpuUsageMeter
+{
+public:
+    CpuUsageMeter();
+
+    double secondsSinceSample() const;
+    double sample();
+
+private:
+    std::clock_t m_lastCpu;
+    std::chrono::steady_clock::time_point m_lastWall;
+};
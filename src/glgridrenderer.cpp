@@ -0,0 +1,129 @@
+#include "glgridrenderer.h"
+#include "glshader.h"
+
+// About Desktop OpenGL function loaders:
+//  Modern desktop OpenGL doesn't have a standard portable header file to load OpenGL function pointers.
+//  Helper libraries are often used for this purpose! Here we are supporting a few common ones (gl3w, glew, glad).
+//  You may use another loader/header of your choice (glext, glLoadGen, etc.), or chose to manually implement your own.
+#if defined(IMGUI_IMPL_OPENGL_LOADER_GL3W)
+#include <GL/gl3w.h>            // Initialize with gl3wInit()
+#elif defined(IMGUI_IMPL_OPENGL_LOADER_GLEW)
+#include <GL/glew.h>            // Initialize with glewInit()
+#elif defined(IMGUI_IMPL_OPENGL_LOADER_GLAD)
+#include <glad/glad.h>          // Initialize with gladLoadGL()
+#elif defined(IMGUI_IMPL_OPENGL_LOADER_GLBINDING2)
+#define GLFW_INCLUDE_NONE       // GLFW including OpenGL headers causes ambiguity or multiple definition errors.
+#include <glbinding/Binding.h>  // Initialize with glbinding::Binding::initialize()
+#include <glbinding/gl/gl.h>
+using namespace gl;
+#elif defined(IMGUI_IMPL_OPENGL_LOADER_GLBINDING3)
+#define GLFW_INCLUDE_NONE       // GLFW including OpenGL headers causes ambiguity or multiple definition errors.
+#include <glbinding/glbinding.h>// Initialize with glbinding::initialize()
+#include <glbinding/gl/gl.h>
+using namespace gl;
+#else
+#include IMGUI_IMPL_OPENGL_LOADER_CUSTOM
+#endif
+
+static const char* VERTEX_SHADER_BODY = R"(
+uniform mat4 ProjMtx;
+uniform vec4 CanvasRect; // xy = start, zw = end, in screen space
+out vec2 Frag_ScreenPos;
+void main()
+{
+    vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1));
+    Frag_ScreenPos = mix(CanvasRect.xy, CanvasRect.zw, corner);
+    gl_Position = ProjMtx * vec4(Frag_ScreenPos, 0.0, 1.0);
+}
+)";
+
+static const char* FRAGMENT_SHADER_BODY = R"(
+uniform vec3 WorldToScreen; // x = zoom, yz = offset
+uniform vec3 Spacings;
+uniform vec3 Alphas;
+uniform vec4 LineColor;
+in vec2 Frag_ScreenPos;
+out vec4 Out_Color;
+
+// How much of a 1px wide line at every multiple of spacing covers this pixel
+float lineCoverage(vec2 worldPos, float spacing)
+{
+    vec2 distPx = abs(fract(worldPos / spacing + 0.5) - 0.5) * spacing * WorldToScreen.x;
+    return clamp(1.0 - min(distPx.x, distPx.y), 0.0, 1.0);
+}
+
+void main()
+{
+    vec2 worldPos = (Frag_ScreenPos - WorldToScreen.yz) / WorldToScreen.x;
+    float alpha = max(max(Alphas.x * lineCoverage(worldPos, Spacings.x),
+                          Alphas.y * lineCoverage(worldPos, Spacings.y)),
+                      Alphas.z * lineCoverage(worldPos, Spacings.z));
+    Out_Color = vec4(LineColor.rgb, LineColor.a * alpha);
+}
+)";
+
+bool GlGridRenderer::isSupported()
+{
+    return GLAD_GL_VERSION_3_0;
+}
+
+GlGridRenderer::GlGridRenderer(const char* glslVersion)
+{
+    m_program = compileShaderProgram(glslVersion, VERTEX_SHADER_BODY, FRAGMENT_SHADER_BODY, "grid");
+
+    m_locProjMtx = glGetUniformLocation(m_program, "ProjMtx");
+    m_locCanvasRect = glGetUniformLocation(m_program, "CanvasRect");
+    m_locWorldToScreen = glGetUniformLocation(m_program, "WorldToScreen");
+    m_locSpacings = glGetUniformLocation(m_program, "Spacings");
+    m_locAlphas = glGetUniformLocation(m_program, "Alphas");
+    m_locLineColor = glGetUniformLocation(m_program, "LineColor");
+
+    glGenVertexArrays(1, &m_vao);
+}
+
+GlGridRenderer::~GlGridRenderer()
+{
+    glDeleteVertexArrays(1, &m_vao);
+    glDeleteProgram(m_program);
+}
+
+void GlGridRenderer::draw(ImDrawList* drawList, const VisualizationModel& viz)
+{
+    if (m_frame != ImGui::GetFrameCount())
+    {
+        m_frame = ImGui::GetFrameCount();
+        m_batches.clear();
+    }
+
+    Batch batch;
+    batch.renderer = this;
+    batch.canvasStart = viz.getCanvas().start;
+    batch.canvasEnd = viz.getCanvas().end;
+    batch.zoom = viz.getZoom();
+    batch.worldToScreenOffset = viz.worldToScreenSpace(ImVec2(0, 0));
+    getGridLevelAlphas(batch.zoom, batch.alphas);
+    m_batches.push_back(batch);
+
+    drawList->AddCallback(renderBatchCallback, &m_batches.back());
+    drawList->AddCallback(ImDrawCallback_ResetRenderState, NULL);
+}
+
+void GlGridRenderer::renderBatchCallback(const ImDrawList*, const ImDrawCmd* cmd)
+{
+    auto batch = static_cast<const Batch*>(cmd->UserCallbackData);
+    batch->renderer->renderBatch(*batch, cmd);
+}
+
+void GlGridRenderer::renderBatch(const Batch& batch, const ImDrawCmd* cmd)
+{
+    glUseProgram(m_program);
+    setupImGuiCallbackState(cmd, m_locProjMtx);
+    glUniform4f(m_locCanvasRect, batch.canvasStart.x, batch.canvasStart.y, batch.canvasEnd.x, batch.canvasEnd.y);
+    glUniform3f(m_locWorldToScreen, batch.zoom, batch.worldToScreenOffset.x, batch.worldToScreenOffset.y);
+    glUniform3f(m_locSpacings, GRID_SPACINGS[0], GRID_SPACINGS[1], GRID_SPACINGS[2]);
+    glUniform3f(m_locAlphas, batch.alphas[0], batch.alphas[1], batch.alphas[2]);
+    glUniform4f(m_locLineColor, 50 / 255.f, 50 / 255.f, 50 / 255.f, 1.f);
+
+    glBindVertexArray(m_vao);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "gridrenderer.h"
+
+#include <deque>
+
+// Draws the grid as one canvas-sized quad, with a fragment shader working out how close each pixel is to a
+// grid line. Costs the same at every zoom level, and fades between spacings exactly like ImGuiGridRenderer.
+class GlGridRenderer : public GridRenderer
+{
+public:
+    static bool isSupported();
+
+    explicit GlGridRenderer(const char* glslVersion);
+    ~GlGridRenderer() override;
+
+    void draw(ImDrawList* drawList, const VisualizationModel& viz) override;
+
+private:
+    struct Batch
+    {
+        GlGridRenderer* renderer;
+        ImVec2 canvasStart;
+        ImVec2 canvasEnd;
+        float zoom;
+        ImVec2 worldToScreenOffset;
+        float alphas[GRID_LEVELS];
+    };
+
+    static void renderBatchCallback(const ImDrawList* parentList, const ImDrawCmd* cmd);
+    void renderBatch(const Batch& batch, const ImDrawCmd* cmd);
+
+    unsigned int m_program = 0;
+    unsigned int m_vao = 0; // Empty, core profiles just won't draw without one bound
+    int m_locProjMtx = 0;
+    int m_locCanvasRect = 0;
+    int m_locWorldToScreen = 0;
+    int m_locSpacings = 0;
+    int m_locAlphas = 0;
+    int m_locLineColor = 0;
+
+    // Grid for each draw() this frame; these have to outlive the frame build until ImGui renders
+    int m_frame = -1;
+    std::deque<Batch> m_batches;
+};
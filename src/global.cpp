@@ -2,11 +2,17 @@
 #include "levelmodel.h"
 
 std::shared_ptr<LevelModel> g_level = {};
-std::shared_ptr<ObjectModel> g_selectedObj = nullptr;
+Selection g_selection;
+SpatialIndex g_levelIndex;
+UndoHistory g_undo;
 VisualizationModel g_viz = {};
 
 bool g_showGravRanges;
 std::string g_jsonFilename;
 
 AssetMan g_assetMan;
-std::shared_ptr<Texture> g_gravRangeTex;
\ No newline at end of file
+std::shared_ptr<Texture> g_gravRangeTex;
+std::shared_ptr<Texture> g_gravRangeOutlineTex;
+
+RedrawScheduler g_redraw;
+FrameArena g_frameArena;
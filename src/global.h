@@ -1,13 +1,20 @@
 #pragma once
 
 #include "assetman.h"
+#include "framearena.h"
 #include "levelmodel.h"
+#include "redrawscheduler.h"
+#include "selection.h"
+#include "spatialindex.h"
+#include "undohistory.h"
 #include "vizmodel.h"
 
 #include <memory>
 
 extern std::shared_ptr<LevelModel> g_level;
-extern std::shared_ptr<ObjectModel> g_selectedObj;
+extern Selection g_selection;
+extern SpatialIndex g_levelIndex;
+extern UndoHistory g_undo;
 extern VisualizationModel g_viz;
 
 extern bool g_showGravRanges;
@@ -15,3 +22,7 @@ extern std::string g_jsonFilename;
 
 extern AssetMan g_assetMan;
 extern std::shared_ptr<Texture> g_gravRangeTex;
+extern std::shared_ptr<Texture> g_gravRangeOutlineTex; // Drawn instead of g_gravRangeTex at far zoom
+
+extern RedrawScheduler g_redraw;
+extern FrameArena g_frameArena; // Reset at the top of runEditor()
@@ -0,0 +1,109 @@
+#include "glshader.h"
+
+// About Desktop OpenGL function loaders:
+//  Modern desktop OpenGL doesn't have a standard portable header file to load OpenGL function pointers.
+//  Helper libraries are often used for this purpose! Here we are supporting a few common ones (gl3w, glew, glad).
+//  You may use another loader/header of your choice (glext, glLoadGen, etc.), or chose to manually implement your own.
+#if defined(IMGUI_IMPL_OPENGL_LOADER_GL3W)
+#include <GL/gl3w.h>            // Initialize with gl3wInit()
+#elif defined(IMGUI_IMPL_OPENGL_LOADER_GLEW)
+#include <GL/glew.h>            // Initialize with glewInit()
+#elif defined(IMGUI_IMPL_OPENGL_LOADER_GLAD)
+#include <glad/glad.h>          // Initialize with gladLoadGL()
+#elif defined(IMGUI_IMPL_OPENGL_LOADER_GLBINDING2)
+#define GLFW_INCLUDE_NONE       // GLFW including OpenGL headers causes ambiguity or multiple definition errors.
+#include <glbinding/Binding.h>  // Initialize with glbinding::Binding::initialize()
+#include <glbinding/gl/gl.h>
+using namespace gl;
+#elif defined(IMGUI_IMPL_OPENGL_LOADER_GLBINDING3)
+#define GLFW_INCLUDE_NONE       // GLFW including OpenGL headers causes ambiguity or multiple definition errors.
+#include <glbinding/glbinding.h>// Initialize with glbinding::initialize()
+#include <glbinding/gl/gl.h>
+using namespace gl;
+#else
+#include IMGUI_IMPL_OPENGL_LOADER_CUSTOM
+#endif
+
+#include <stdexcept>
+
+static GLuint compileShader(GLenum type, const char* glslVersion, const char* body, const std::string& what)
+{
+    std::string versionLine = std::string(glslVersion) + "\n";
+    const char* sources[] = {versionLine.c_str(), body};
+
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 2, sources, NULL);
+    glCompileShader(shader);
+
+    GLint status = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+    if (status == GL_FALSE)
+    {
+        char log[1024] = "";
+        glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+        glDeleteShader(shader);
+        throw std::runtime_error("Could not compile " + what + " shader: " + log);
+    }
+
+    return shader;
+}
+
+unsigned int compileShaderProgram(const char* glslVersion, const char* vertexBody, const char* fragmentBody,
+                                  const std::string& what)
+{
+    GLuint vertShader = compileShader(GL_VERTEX_SHADER, glslVersion, vertexBody, what);
+    GLuint fragShader;
+    try
+    {
+        fragShader = compileShader(GL_FRAGMENT_SHADER, glslVersion, fragmentBody, what);
+    } catch (...)
+    {
+        glDeleteShader(vertShader);
+        throw;
+    }
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertShader);
+    glAttachShader(program, fragShader);
+    glLinkProgram(program);
+    glDeleteShader(vertShader);
+    glDeleteShader(fragShader);
+
+    GLint status = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status == GL_FALSE)
+    {
+        char log[1024] = "";
+        glGetProgramInfoLog(program, sizeof(log), NULL, log);
+        glDeleteProgram(program);
+        throw std::runtime_error("Could not link " + what + " shader: " + log);
+    }
+
+    return program;
+}
+
+void setupImGuiCallbackState(const ImDrawCmd* cmd, int locProjMtx)
+{
+    ImDrawData* drawData = ImGui::GetDrawData();
+    ImVec2 clipOff = drawData->DisplayPos;
+    ImVec2 clipScale = drawData->FramebufferScale;
+    int fbHeight = static_cast<int>(drawData->DisplaySize.y * clipScale.y);
+
+    float L = drawData->DisplayPos.x;
+    float R = drawData->DisplayPos.x + drawData->DisplaySize.x;
+    float T = drawData->DisplayPos.y;
+    float B = drawData->DisplayPos.y + drawData->DisplaySize.y;
+    const float orthoProjection[4][4] =
+    {
+        { 2.0f/(R-L),   0.0f,         0.0f,   0.0f },
+        { 0.0f,         2.0f/(T-B),   0.0f,   0.0f },
+        { 0.0f,         0.0f,        -1.0f,   0.0f },
+        { (R+L)/(L-R),  (T+B)/(B-T),  0.0f,   1.0f },
+    };
+    glUniformMatrix4fv(locProjMtx, 1, GL_FALSE, &orthoProjection[0][0]);
+
+    glScissor(static_cast<int>((cmd->ClipRect.x - clipOff.x) * clipScale.x),
+              static_cast<int>(fbHeight - (cmd->ClipRect.w - clipOff.y) * clipScale.y),
+              static_cast<int>((cmd->ClipRect.z - cmd->ClipRect.x) * clipScale.x),
+              static_cast<int>((cmd->ClipRect.w - cmd->ClipRect.y) * clipScale.y));
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "imgui.h"
+
+#include <string>
+
+// Compiles and links a vertex and fragment shader, each prefixed with the #version line in glslVersion.
+// what names the shader in the error thrown if that fails.
+unsigned int compileShaderProgram(const char* glslVersion, const char* vertexBody, const char* fragmentBody,
+                                  const std::string& what);
+
+// From inside an ImGui draw callback, sets the projection uniform and scissor ImGui would use for cmd itself
+void setupImGuiCallbackState(const ImDrawCmd* cmd, int locProjMtx);
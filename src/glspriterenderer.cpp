@@ -0,0 +1,164 @@
+#include "glspriterenderer.h"
+#include "framestats.h"
+#include "glshader.h"
+
+// About Desktop OpenGL function loaders:
+//  Modern desktop OpenGL doesn't have a standard portable header file to load OpenGL function pointers.
+//  Helper libraries are often used for this purpose! Here we are supporting a few common ones (gl3w, glew, glad).
+//  You may use another loader/header of your choice (glext, glLoadGen, etc.), or chose to manually implement your own.
+#if defined(IMGUI_IMPL_OPENGL_LOADER_GL3W)
+#include <GL/gl3w.h>            // Initialize with gl3wInit()
+#elif defined(IMGUI_IMPL_OPENGL_LOADER_GLEW)
+#include <GL/glew.h>            // Initialize with glewInit()
+#elif defined(IMGUI_IMPL_OPENGL_LOADER_GLAD)
+#include <glad/glad.h>          // Initialize with gladLoadGL()
+#elif defined(IMGUI_IMPL_OPENGL_LOADER_GLBINDING2)
+#define GLFW_INCLUDE_NONE       // GLFW including OpenGL headers causes ambiguity or multiple definition errors.
+#include <glbinding/Binding.h>  // Initialize with glbinding::Binding::initialize()
+#include <glbinding/gl/gl.h>
+using namespace gl;
+#elif defined(IMGUI_IMPL_OPENGL_LOADER_GLBINDING3)
+#define GLFW_INCLUDE_NONE       // GLFW including OpenGL headers causes ambiguity or multiple definition errors.
+#include <glbinding/glbinding.h>// Initialize with glbinding::initialize()
+#include <glbinding/gl/gl.h>
+using namespace gl;
+#else
+#include IMGUI_IMPL_OPENGL_LOADER_CUSTOM
+#endif
+
+#include <cstddef>
+#include <cstdint>
+
+static const char* VERTEX_SHADER_BODY = R"(
+uniform mat4 ProjMtx;
+uniform vec4 WorldToScreen; // xy = scale, zw = offset
+in vec4 InstRect; // xy = center, zw = half size, in world space
+in vec4 InstUv; // xy = uv0, zw = uv1
+out vec2 Frag_UV;
+void main()
+{
+    // Quad corners come from the vertex index, so there's no per-vertex buffer at all
+    vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1));
+    vec2 worldPos = InstRect.xy + (corner * 2.0 - 1.0) * InstRect.zw;
+    vec2 screenPos = worldPos * WorldToScreen.xy + WorldToScreen.zw;
+    Frag_UV = mix(InstUv.xy, InstUv.zw, corner);
+    gl_Position = ProjMtx * vec4(screenPos, 0.0, 1.0);
+}
+)";
+
+static const char* FRAGMENT_SHADER_BODY = R"(
+uniform sampler2D Texture;
+in vec2 Frag_UV;
+out vec4 Out_Color;
+void main()
+{
+    Out_Color = texture(Texture, Frag_UV);
+}
+)";
+
+bool GlSpriteRenderer::isSupported()
+{
+    return GLAD_GL_VERSION_3_3;
+}
+
+GlSpriteRenderer::GlSpriteRenderer(const char* glslVersion)
+{
+    m_program = compileShaderProgram(glslVersion, VERTEX_SHADER_BODY, FRAGMENT_SHADER_BODY, "sprite");
+
+    m_locProjMtx = glGetUniformLocation(m_program, "ProjMtx");
+    m_locWorldToScreen = glGetUniformLocation(m_program, "WorldToScreen");
+    m_locTexture = glGetUniformLocation(m_program, "Texture");
+    m_locInstRect = glGetAttribLocation(m_program, "InstRect");
+    m_locInstUv = glGetAttribLocation(m_program, "InstUv");
+
+    glGenBuffers(1, &m_instanceBuffer);
+    glGenVertexArrays(1, &m_vao);
+
+    // Remember what ImGui had bound, we're likely being created in the middle of its setup
+    GLint lastVao, lastArrayBuffer;
+    glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &lastVao);
+    glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &lastArrayBuffer);
+
+    glBindVertexArray(m_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+    glEnableVertexAttribArray(m_locInstRect);
+    glEnableVertexAttribArray(m_locInstUv);
+    glVertexAttribDivisor(m_locInstRect, 1);
+    glVertexAttribDivisor(m_locInstUv, 1);
+
+    glBindVertexArray(lastVao);
+    glBindBuffer(GL_ARRAY_BUFFER, lastArrayBuffer);
+}
+
+GlSpriteRenderer::~GlSpriteRenderer()
+{
+    glDeleteVertexArrays(1, &m_vao);
+    glDeleteBuffers(1, &m_instanceBuffer);
+    glDeleteProgram(m_program);
+}
+
+void GlSpriteRenderer::setSprites(const std::vector<SpriteInstance>& sprites)
+{
+    findSpriteRuns(sprites, m_runs);
+
+    // We're in the middle of building the ImGui frame, which doesn't expect anything to have changed bindings
+    GLint lastArrayBuffer;
+    glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &lastArrayBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sprites.size() * sizeof(SpriteInstance), sprites.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, lastArrayBuffer);
+    g_renderCounters.bytesUploaded += sprites.size() * sizeof(SpriteInstance);
+}
+
+void GlSpriteRenderer::draw(ImDrawList* drawList, const VisualizationModel& viz)
+{
+    if (m_frame != ImGui::GetFrameCount())
+    {
+        m_frame = ImGui::GetFrameCount();
+        m_batches.clear();
+    }
+    if (m_runs.empty()) return;
+
+    // screen = world * zoom + origin, same as VisualizationModel::worldToScreenSpace()
+    Batch batch;
+    batch.renderer = this;
+    batch.worldToScreenScale = ImVec2(viz.getZoom(), viz.getZoom());
+    batch.worldToScreenOffset = viz.worldToScreenSpace(ImVec2(0, 0));
+    m_batches.push_back(batch);
+
+    drawList->AddCallback(renderBatchCallback, &m_batches.back());
+    g_renderCounters.textureBinds += static_cast<int>(m_runs.size());
+    drawList->AddCallback(ImDrawCallback_ResetRenderState, NULL);
+}
+
+void GlSpriteRenderer::renderBatchCallback(const ImDrawList*, const ImDrawCmd* cmd)
+{
+    auto batch = static_cast<const Batch*>(cmd->UserCallbackData);
+    batch->renderer->renderBatch(*batch, cmd);
+}
+
+void GlSpriteRenderer::renderBatch(const Batch& batch, const ImDrawCmd* cmd)
+{
+    glUseProgram(m_program);
+    setupImGuiCallbackState(cmd, m_locProjMtx);
+    glUniform4f(m_locWorldToScreen, batch.worldToScreenScale.x, batch.worldToScreenScale.y,
+                batch.worldToScreenOffset.x, batch.worldToScreenOffset.y);
+    glUniform1i(m_locTexture, 0);
+    glActiveTexture(GL_TEXTURE0);
+
+    glBindVertexArray(m_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+
+    // No base instance in GL 3.3, so each run points the attributes at its own slice of the buffer instead
+    for (auto& run : m_runs)
+    {
+        size_t offset = run.first * sizeof(SpriteInstance);
+        glVertexAttribPointer(m_locInstRect, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance),
+                              reinterpret_cast<void*>(offset + offsetof(SpriteInstance, center)));
+        glVertexAttribPointer(m_locInstUv, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance),
+                              reinterpret_cast<void*>(offset + offsetof(SpriteInstance, uv0)));
+
+        glBindTexture(GL_TEXTURE_2D, static_cast<GLuint>(reinterpret_cast<intptr_t>(run.tex)));
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(run.count));
+    }
+}
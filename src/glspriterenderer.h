@@ -0,0 +1,47 @@
+#pragma once
+
+#include "spriterenderer.h"
+
+#include <deque>
+
+// Keeps the level sprites in a GL instance buffer, re-uploaded only when they change, and draws them with one
+// instanced draw call per run of sprites sharing a texture from inside an ImGui draw callback.
+// Camera pans and zooms are just shader uniforms.
+class GlSpriteRenderer : public SpriteRenderer
+{
+public:
+    // Needs instanced arrays, i.e. GL 3.3
+    static bool isSupported();
+
+    explicit GlSpriteRenderer(const char* glslVersion);
+    ~GlSpriteRenderer() override;
+
+    void setSprites(const std::vector<SpriteInstance>& sprites) override;
+    void draw(ImDrawList* drawList, const VisualizationModel& viz) override;
+
+private:
+    struct Batch
+    {
+        GlSpriteRenderer* renderer;
+        ImVec2 worldToScreenScale;
+        ImVec2 worldToScreenOffset;
+    };
+
+    static void renderBatchCallback(const ImDrawList* parentList, const ImDrawCmd* cmd);
+    void renderBatch(const Batch& batch, const ImDrawCmd* cmd);
+
+    unsigned int m_program = 0;
+    unsigned int m_vao = 0;
+    unsigned int m_instanceBuffer = 0;
+    int m_locProjMtx = 0;
+    int m_locWorldToScreen = 0;
+    int m_locTexture = 0;
+    int m_locInstRect = 0;
+    int m_locInstUv = 0;
+
+    std::vector<SpriteRun> m_runs;
+
+    // Camera for each draw() this frame; these have to outlive the frame build until ImGui renders
+    int m_frame = -1;
+    std::deque<Batch> m_batches;
+};
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "textureuploader.h"
+
+class GlTextureUploader : public TextureUploader
+{
+public:
+    void* upload(const unsigned char* rgbaPixels, int width, int height) override;
+    void update(void* id, const unsigned char* rgbaRows, int width, int firstRow, int rows) override;
+};
@@ -0,0 +1,220 @@
+#include "gravityfield.h"
+#include "profiler.h"
+#include "trajectory.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <future>
+#include <thread>
+
+static constexpr int TILES_PER_ROW = GravityFieldMap::MAX_SIZE / GravityFieldMap::TILE_SIZE;
+
+// Pull strengths (world units/s^2) the colors are scaled between, logarithmically
+static constexpr float WEAKEST_PULL = 20;
+static constexpr float STRONGEST_PULL = 5000;
+
+bool GravityFieldView::operator==(const GravityFieldView& other) const
+{
+    return worldOrigin.x == other.worldOrigin.x && worldOrigin.y == other.worldOrigin.y &&
+           worldPerTexel == other.worldPerTexel && width == other.width && height == other.height &&
+           rangeRadiusPerScale == other.rangeRadiusPerScale && gravity == other.gravity;
+}
+
+GravityFieldMap::GravityFieldMap():
+    m_pixels(static_cast<size_t>(MAX_SIZE) * MAX_SIZE * 4), m_tileDirty(TILES_PER_ROW * TILES_PER_ROW) {}
+
+void GravityFieldMap::markDirty(const Source& source, float rangeRadius)
+{
+    float texelsPerWorld = 1 / m_view.worldPerTexel;
+    int startX = static_cast<int>(std::floor((source.x - rangeRadius - m_view.worldOrigin.x) * texelsPerWorld));
+    int startY = static_cast<int>(std::floor((source.y - rangeRadius - m_view.worldOrigin.y) * texelsPerWorld));
+    int endX = static_cast<int>(std::floor((source.x + rangeRadius - m_view.worldOrigin.x) * texelsPerWorld));
+    int endY = static_cast<int>(std::floor((source.y + rangeRadius - m_view.worldOrigin.y) * texelsPerWorld));
+
+    int tileStartX = std::max(startX / TILE_SIZE, 0);
+    int tileStartY = std::max(startY / TILE_SIZE, 0);
+    int tileEndX = std::min(endX / TILE_SIZE, (m_view.width - 1) / TILE_SIZE);
+    int tileEndY = std::min(endY / TILE_SIZE, (m_view.height - 1) / TILE_SIZE);
+
+    for (int ty = tileStartY; ty <= tileEndY; ty++)
+    {
+        for (int tx = tileStartX; tx <= tileEndX; tx++) m_tileDirty[ty * TILES_PER_ROW + tx] = 1;
+    }
+}
+
+static void hsvToRgba(float h, float s, float v, float a, unsigned char* out)
+{
+    float r, g, b;
+    float sector = h * 6;
+    int i = static_cast<int>(sector) % 6;
+    float f = sector - std::floor(sector);
+    float p = v * (1 - s), q = v * (1 - s * f), t = v * (1 - s * (1 - f));
+    switch (i)
+    {
+    case 0: r = v; g = t; b = p; break;
+    case 1: r = q; g = v; b = p; break;
+    case 2: r = p; g = v; b = t; break;
+    case 3: r = p; g = q; b = v; break;
+    case 4: r = t; g = p; b = v; break;
+    default: r = v; g = p; b = q; break;
+    }
+
+    out[0] = static_cast<unsigned char>(r * 255);
+    out[1] = static_cast<unsigned char>(g * 255);
+    out[2] = static_cast<unsigned char>(b * 255);
+    out[3] = static_cast<unsigned char>(a * 255);
+}
+
+void GravityFieldMap::computeTile(int tile, std::vector<const Source*>& nearby)
+{
+    int tileX = tile % TILES_PER_ROW * TILE_SIZE;
+    int tileY = tile / TILES_PER_ROW * TILE_SIZE;
+    float wpt = m_view.worldPerTexel;
+    ImVec2 tileStart(m_view.worldOrigin.x + tileX * wpt, m_view.worldOrigin.y + tileY * wpt);
+    ImVec2 tileEnd(tileStart.x + TILE_SIZE * wpt, tileStart.y + TILE_SIZE * wpt);
+
+    // Only the planets whose range reaches into this tile
+    nearby.clear();
+    for (const Source* source : m_sourceList)
+    {
+        float dx = source->x - std::clamp(source->x, tileStart.x, tileEnd.x);
+        float dy = source->y - std::clamp(source->y, tileStart.y, tileEnd.y);
+        if (dx * dx + dy * dy < source->rangeSq) nearby.push_back(source);
+    }
+
+    float texelX[TILE_SIZE];
+    for (int lane = 0; lane < TILE_SIZE; lane++) texelX[lane] = tileStart.x + (lane + 0.5f) * wpt;
+
+    int rows = std::min(TILE_SIZE, m_view.height - tileY);
+    int cols = std::min(TILE_SIZE, m_view.width - tileX);
+    for (int row = 0; row < rows; row++)
+    {
+        float y = tileStart.y + (row + 0.5f) * wpt;
+
+        // One lane per texel in the row. Like TrajectorySimulator, no branches, so it vectorizes (the
+        // divide has to come before the select, or GCC makes it conditional again).
+        float accelX[TILE_SIZE] = {}, accelY[TILE_SIZE] = {};
+        for (const Source* source : nearby)
+        {
+            float sx = source->x, sy = source->y, rangeSq = source->rangeSq, strength = source->strength;
+            for (int lane = 0; lane < TILE_SIZE; lane++)
+            {
+                float dx = sx - texelX[lane];
+                float dy = sy - y;
+                float distSq = dx * dx + dy * dy + 1e-3f;
+                float inRange = distSq < rangeSq ? 1.f : 0.f;
+                float pull = strength / distSq * inRange;
+                accelX[lane] += dx * pull;
+                accelY[lane] += dy * pull;
+            }
+        }
+
+        unsigned char* out = &m_pixels[(static_cast<size_t>(tileY + row) * MAX_SIZE + tileX) * 4];
+        for (int col = 0; col < cols; col++, out += 4)
+        {
+            float pull = std::sqrt(accelX[col] * accelX[col] + accelY[col] * accelY[col]);
+            if (pull == 0)
+            {
+                out[0] = out[1] = out[2] = out[3] = 0;
+                continue;
+            }
+
+            float strength = std::log(std::max(pull, WEAKEST_PULL) / WEAKEST_PULL) / std::log(STRONGEST_PULL / WEAKEST_PULL);
+            strength = std::min(strength, 1.f);
+            float hue = std::atan2(accelY[col], accelX[col]) / 6.2831853f + 0.5f;
+            hsvToRgba(std::min(hue, 0.9999f), 0.75f, 0.35f + 0.65f * strength, 0.3f + 0.55f * strength, out);
+        }
+    }
+}
+
+RowSpan GravityFieldMap::update(const LevelObjects& objects, const GravityFieldView& view)
+{
+    PROFILE_ZONE("Gravity field");
+    bool viewChanged = !m_valid || view != m_view;
+    m_view = view;
+    m_valid = true;
+    m_stamp++;
+
+    // Dirty whatever's in range of a planet that changed, both where it was and where it is now
+    for (size_t row = 0; row < objects.size(); row++)
+    {
+        if (objects.kind[row] != ObjectKind::PLANET) continue;
+
+        float rangeRadius = view.rangeRadiusPerScale * objects.scale[row];
+        Source current{objects.pos[row].x, objects.pos[row].y, rangeRadius * rangeRadius,
+                       planetPullStrength(objects, row, view.gravity), m_stamp};
+
+        auto inserted = m_sources.try_emplace(objects.idAt(row), current);
+        Source& source = inserted.first->second;
+        if (inserted.second)
+        {
+            if (!viewChanged) markDirty(current, rangeRadius);
+        }
+        else if (source.x != current.x || source.y != current.y || source.rangeSq != current.rangeSq ||
+                 source.strength != current.strength)
+        {
+            if (!viewChanged)
+            {
+                markDirty(source, std::sqrt(source.rangeSq));
+                markDirty(current, rangeRadius);
+            }
+            source = current;
+        }
+        source.stamp = m_stamp;
+    }
+
+    for (auto it = m_sources.begin(); it != m_sources.end();)
+    {
+        if (it->second.stamp == m_stamp)
+        {
+            ++it;
+            continue;
+        }
+        if (!viewChanged) markDirty(it->second, std::sqrt(it->second.rangeSq));
+        it = m_sources.erase(it);
+    }
+
+    m_sourceList.clear();
+    for (auto& entry : m_sources) m_sourceList.push_back(&entry.second);
+
+    int tilesX = (view.width + TILE_SIZE - 1) / TILE_SIZE;
+    int tilesY = (view.height + TILE_SIZE - 1) / TILE_SIZE;
+    m_dirtyTiles.clear();
+    int firstTileRow = tilesY;
+    int lastTileRow = -1;
+    for (int ty = 0; ty < tilesY; ty++)
+    {
+        for (int tx = 0; tx < tilesX; tx++)
+        {
+            uint8_t& dirty = m_tileDirty[ty * TILES_PER_ROW + tx];
+            if (!dirty && !viewChanged) continue;
+            dirty = 0;
+            m_dirtyTiles.push_back(ty * TILES_PER_ROW + tx);
+            firstTileRow = std::min(firstTileRow, ty);
+            lastTileRow = ty;
+        }
+    }
+    m_lastTilesComputed = static_cast<int>(m_dirtyTiles.size());
+    if (m_dirtyTiles.empty()) return RowSpan{0, 0};
+
+    // Spread the tiles over a few threads, each grabbing the next one that's left
+    constexpr size_t TILES_PER_THREAD = 16;
+    size_t threads = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()),
+                                      (m_dirtyTiles.size() + TILES_PER_THREAD - 1) / TILES_PER_THREAD);
+    std::atomic<size_t> nextTile{0};
+    auto work = [&]() {
+        PROFILE_ZONE("Gravity field tiles");
+        std::vector<const Source*> nearby;
+        nearby.reserve(m_sourceList.size());
+        for (size_t i = nextTile++; i < m_dirtyTiles.size(); i = nextTile++) computeTile(m_dirtyTiles[i], nearby);
+    };
+
+    std::vector<std::future<void>> helpers;
+    for (size_t i = 1; i < threads; i++) helpers.push_back(std::async(std::launch::async, work));
+    work();
+    for (auto& helper : helpers) helper.get();
+
+    int firstRow = firstTileRow * TILE_SIZE;
+    return RowSpan{firstRow, std::min((lastTileRow + 1) * TILE_SIZE, view.height) - firstRow};
+}
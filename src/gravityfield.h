@@ -0,0 +1,77 @@
+#pragma once
+
+#include "levelmodel.h"
+
+#include "imgui.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Where the view is and how finely to sample it. Texel (0, 0)'s top left corner is at worldOrigin.
+struct GravityFieldView
+{
+    ImVec2 worldOrigin;
+    float worldPerTexel;
+    int width; // Texels, at most GravityFieldMap::MAX_SIZE
+    int height;
+    float rangeRadiusPerScale;
+    float gravity;
+
+    bool operator==(const GravityFieldView& other) const;
+    bool operator!=(const GravityFieldView& other) const { return !(*this == other); }
+};
+
+// The planets' summed gravity (same model as trajectory.h) sampled over the view into an RGBA image. Hue is
+// the direction of the pull and brightness its strength; places nothing pulls on are left transparent.
+//
+// Band of rows of an image that changed
+struct RowSpan
+{
+    int first;
+    int count; // 0 if nothing changed
+};
+
+// The image is split into tiles that get computed in parallel. After the first update, only tiles in range
+// of planets that were added, removed or changed get recomputed, unless the view itself moved.
+class GravityFieldMap
+{
+public:
+    static constexpr int MAX_SIZE = 512;
+    static constexpr int TILE_SIZE = 16;
+
+    GravityFieldMap();
+
+    // Returns the rows of pixels() that changed, from the first dirty tile's top to the last one's bottom
+    RowSpan update(const LevelObjects& objects, const GravityFieldView& view);
+
+    // MAX_SIZE x MAX_SIZE, of which the view's width x height is used
+    const unsigned char* pixels() const { return m_pixels.data(); }
+
+    int lastTilesComputed() const { return m_lastTilesComputed; }
+
+private:
+    struct Source
+    {
+        float x;
+        float y;
+        float rangeSq;
+        float strength; // planetPullStrength()
+        uint64_t stamp; // Last update this planet was seen in
+    };
+
+    void markDirty(const Source& source, float rangeRadius);
+    void computeTile(int tile, std::vector<const Source*>& nearby);
+
+    std::vector<unsigned char> m_pixels;
+    std::vector<uint8_t> m_tileDirty;
+    std::vector<int> m_dirtyTiles;
+
+    bool m_valid = false;
+    GravityFieldView m_view;
+    uint64_t m_stamp = 0;
+    std::unordered_map<ObjectId, Source> m_sources;
+    std::vector<const Source*> m_sourceList;
+
+    int m_lastTilesComputed = 0;
+};
@@ -0,0 +1,53 @@
+#include "gridrenderer.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Lines closer than this many pixels are hidden, and they're fully visible from GRID_OPAQUE_PX apart
+constexpr float GRID_MIN_PX = 12.f;
+constexpr float GRID_OPAQUE_PX = 48.f;
+
+void getGridLevelAlphas(float zoom, float (&alphas)[GRID_LEVELS])
+{
+    for (int level = 0; level < GRID_LEVELS; level++)
+    {
+        float px = GRID_SPACINGS[level] * zoom;
+        alphas[level] = std::min(std::max((px - GRID_MIN_PX) / (GRID_OPAQUE_PX - GRID_MIN_PX), 0.f), 1.f);
+    }
+}
+
+void ImGuiGridRenderer::draw(ImDrawList* drawList, const VisualizationModel& viz)
+{
+    const Canvas& canvas = viz.getCanvas();
+    ImVec2 worldStart = viz.screenToWorldSpace(canvas.start);
+    ImVec2 worldEnd = viz.screenToWorldSpace(canvas.end);
+
+    float alphas[GRID_LEVELS];
+    getGridLevelAlphas(viz.getZoom(), alphas);
+
+    for (int level = 0; level < GRID_LEVELS; level++)
+    {
+        if (alphas[level] <= 0) continue;
+
+        float spacing = GRID_SPACINGS[level];
+        ImU32 color = IM_COL32(50, 50, 50, static_cast<int>(alphas[level] * 255));
+
+        // Lines that a coarser level also draws are left to that level, so they aren't blended twice
+        bool coarserVisible = level + 1 < GRID_LEVELS && alphas[level + 1] > 0;
+        auto coveredByCoarser = [&](long long i) { return coarserVisible && i % 10 == 0; };
+
+        for (long long i = static_cast<long long>(std::ceil(worldStart.x / spacing)); i * spacing < worldEnd.x; i++)
+        {
+            if (coveredByCoarser(i)) continue;
+            float x = viz.worldToScreenSpace(ImVec2(i * spacing, 0)).x;
+            drawList->AddLine(ImVec2(x, canvas.start.y), ImVec2(x, canvas.end.y), color);
+        }
+
+        for (long long i = static_cast<long long>(std::ceil(worldStart.y / spacing)); i * spacing < worldEnd.y; i++)
+        {
+            if (coveredByCoarser(i)) continue;
+            float y = viz.worldToScreenSpace(ImVec2(0, i * spacing)).y;
+            drawList->AddLine(ImVec2(canvas.start.x, y), ImVec2(canvas.end.x, y), color);
+        }
+    }
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "imgui.h"
+#include "vizmodel.h"
+
+constexpr int GRID_LEVELS = 3;
+constexpr float GRID_SPACINGS[GRID_LEVELS] = {100.f, 1000.f, 10000.f};
+
+// How visible each grid spacing is at this zoom. Spacings fade out as their lines get too close together on
+// screen, so at most a canvas-sized handful of lines are ever drawn no matter how far out you zoom.
+void getGridLevelAlphas(float zoom, float (&alphas)[GRID_LEVELS]);
+
+// Draws the background grid across the whole canvas
+class GridRenderer
+{
+public:
+    virtual ~GridRenderer() = default;
+    virtual void draw(ImDrawList* drawList, const VisualizationModel& viz) = 0;
+};
+
+// One AddLine() per visible grid line, which works anywhere ImGui does (including headless)
+class ImGuiGridRenderer : public GridRenderer
+{
+public:
+    void draw(ImDrawList* drawList, const VisualizationModel& viz) override;
+};
@@ -0,0 +1,235 @@
+#include "inputscript.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+// Plain text, so scripts are easy to diff and hand-edit:
+//   mwginput 1
+//   display <width> <height>
+//   ini <window layout, with newlines escaped>
+//   keys <key>...        Keys held when recording started
+//   f <deltaTime> <mouseX> <mouseY> <mouseButtons> <mouseWheel> <keyMods>
+//   k <key> <down>       Key change during the preceding frame
+//   c <codepoint>        Typed character during the preceding frame
+//   level <path>         Level loaded during the preceding frame
+static const char* SCRIPT_HEADER = "mwginput 1";
+
+static std::string escapeLine(const std::string& str)
+{
+    std::string out;
+    for (char c : str)
+    {
+        if (c == '\\') out += "\\\\";
+        else if (c == '\n') out += "\\n";
+        else out += c;
+    }
+    return out;
+}
+
+static std::string unescapeLine(const std::string& str)
+{
+    std::string out;
+    for (size_t i = 0; i < str.size(); i++)
+    {
+        if (str[i] == '\\' && i + 1 < str.size())
+        {
+            out += str[i + 1] == 'n' ? '\n' : str[i + 1];
+            i++;
+        }
+        else out += str[i];
+    }
+    return out;
+}
+
+InputScript loadInputScript(const std::string& filename)
+{
+    std::ifstream f(filename);
+    if (!f) throw std::runtime_error("Could not open input script: " + filename);
+
+    std::string line;
+    if (!std::getline(f, line) || line != SCRIPT_HEADER)
+    {
+        throw std::runtime_error("Not an input script: " + filename);
+    }
+
+    InputScript script{};
+    int lineNum = 1;
+    while (std::getline(f, line))
+    {
+        lineNum++;
+        if (line.empty() || line[0] == '#') continue;
+
+        std::istringstream ss(line);
+        std::string tag;
+        ss >> tag;
+
+        auto lineError = [&](const std::string& what) {
+            return std::runtime_error(what + " on line " + std::to_string(lineNum) + " of " + filename);
+        };
+
+        if (tag == "f")
+        {
+            InputFrame frame{};
+            ss >> frame.deltaTime >> frame.mousePos.x >> frame.mousePos.y >> frame.mouseButtons >> frame.mouseWheel;
+            if (!ss) throw lineError("Malformed frame");
+            if (!(ss >> frame.keyMods)) frame.keyMods = 0;
+            script.frames.push_back(std::move(frame));
+        }
+        else if (tag == "display")
+        {
+            ss >> script.displaySize.x >> script.displaySize.y;
+            if (!ss) throw lineError("Malformed display size");
+        }
+        else if (tag == "ini")
+        {
+            script.iniSettings = unescapeLine(line.substr(tag.size() + 1));
+        }
+        else if (tag == "keys")
+        {
+            int key;
+            while (ss >> key)
+            {
+                if (key < 0 || key >= 512) throw lineError("Malformed held key");
+                script.keysDownAtStart.push_back(key);
+            }
+            if (!ss.eof()) throw lineError("Malformed held key");
+        }
+        else if (tag == "k" || tag == "c" || tag == "level")
+        {
+            if (script.frames.empty()) throw lineError("Input before the first frame");
+            InputFrame& frame = script.frames.back();
+
+            if (tag == "k")
+            {
+                KeyEvent event{};
+                ss >> event.key >> event.down;
+                if (!ss || event.key < 0 || event.key >= 512) throw lineError("Malformed key event");
+                frame.keyEvents.push_back(event);
+            }
+            else if (tag == "c")
+            {
+                unsigned int codepoint;
+                if (!(ss >> codepoint)) throw lineError("Malformed character");
+                frame.chars.push_back(static_cast<ImWchar>(codepoint));
+            }
+            else
+            {
+                frame.levelPath = line.substr(tag.size() + 1);
+            }
+        }
+        else
+        {
+            throw lineError("Unknown entry '" + tag + "'");
+        }
+    }
+
+    return script;
+}
+
+void saveInputScript(const std::string& filename, const InputScript& script)
+{
+    std::ofstream f(filename);
+    if (!f) throw std::runtime_error("Could not write input script: " + filename);
+    // Enough digits that floats read back bit for bit, or replays drift from what was recorded
+    f << std::setprecision(std::numeric_limits<float>::max_digits10);
+
+    f << SCRIPT_HEADER << '\n';
+    f << "display " << script.displaySize.x << ' ' << script.displaySize.y << '\n';
+    if (!script.iniSettings.empty()) f << "ini " << escapeLine(script.iniSettings) << '\n';
+    if (!script.keysDownAtStart.empty())
+    {
+        f << "keys";
+        for (int key : script.keysDownAtStart) f << ' ' << key;
+        f << '\n';
+    }
+
+    for (auto& frame : script.frames)
+    {
+        f << "f " << frame.deltaTime << ' ' << frame.mousePos.x << ' ' << frame.mousePos.y << ' '
+          << frame.mouseButtons << ' ' << frame.mouseWheel << ' ' << frame.keyMods << '\n';
+        for (auto& event : frame.keyEvents) f << "k " << event.key << ' ' << event.down << '\n';
+        for (ImWchar c : frame.chars) f << "c " << static_cast<unsigned int>(c) << '\n';
+        if (!frame.levelPath.empty()) f << "level " << frame.levelPath << '\n';
+    }
+}
+
+void InputPlayer::begin(const InputScript& script)
+{
+    std::fill(std::begin(m_keysDown), std::end(m_keysDown), false);
+    for (int key : script.keysDownAtStart) m_keysDown[key] = true;
+}
+
+void InputPlayer::applyFrame(ImGuiIO& io, const InputFrame& frame)
+{
+    io.DeltaTime = frame.deltaTime;
+    io.MousePos = frame.mousePos;
+    for (int i = 0; i < IM_ARRAYSIZE(io.MouseDown); i++)
+    {
+        io.MouseDown[i] = (frame.mouseButtons & (1 << i)) != 0;
+    }
+    io.MouseWheel = frame.mouseWheel;
+
+    io.KeyCtrl = (frame.keyMods & 1) != 0;
+    io.KeyShift = (frame.keyMods & 2) != 0;
+    io.KeyAlt = (frame.keyMods & 4) != 0;
+    io.KeySuper = (frame.keyMods & 8) != 0;
+    for (auto& event : frame.keyEvents)
+    {
+        m_keysDown[event.key] = event.down;
+    }
+    std::copy(std::begin(m_keysDown), std::end(m_keysDown), io.KeysDown);
+
+    io.InputQueueCharacters.resize(0);
+    for (ImWchar c : frame.chars)
+    {
+        io.AddInputCharacter(c);
+    }
+}
+
+void InputRecorder::begin(const ImGuiIO& io)
+{
+    m_script = InputScript{};
+    m_script.displaySize = io.DisplaySize;
+    m_script.iniSettings = ImGui::SaveIniSettingsToMemory();
+    std::copy(std::begin(io.KeysDown), std::end(io.KeysDown), m_keysDown);
+    for (int key = 0; key < IM_ARRAYSIZE(io.KeysDown); key++)
+    {
+        if (io.KeysDown[key]) m_script.keysDownAtStart.push_back(key);
+    }
+}
+
+void InputRecorder::captureFrame(const ImGuiIO& io)
+{
+    InputFrame frame{};
+    frame.deltaTime = io.DeltaTime;
+    frame.mousePos = io.MousePos;
+    for (int i = 0; i < IM_ARRAYSIZE(io.MouseDown); i++)
+    {
+        if (io.MouseDown[i]) frame.mouseButtons |= 1 << i;
+    }
+    frame.mouseWheel = io.MouseWheel;
+    frame.keyMods = (io.KeyCtrl ? 1 : 0) | (io.KeyShift ? 2 : 0) | (io.KeyAlt ? 4 : 0) | (io.KeySuper ? 8 : 0);
+
+    // Only key changes are logged, which keeps the log small
+    for (int key = 0; key < IM_ARRAYSIZE(io.KeysDown); key++)
+    {
+        if (io.KeysDown[key] != m_keysDown[key])
+        {
+            frame.keyEvents.push_back(KeyEvent{key, io.KeysDown[key]});
+            m_keysDown[key] = io.KeysDown[key];
+        }
+    }
+    frame.chars.assign(io.InputQueueCharacters.begin(), io.InputQueueCharacters.end());
+
+    m_script.frames.push_back(std::move(frame));
+}
+
+void InputRecorder::noteLevelLoaded(const std::string& levelPath)
+{
+    if (!m_script.frames.empty()) m_script.frames.back().levelPath = levelPath;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "imgui.h"
+
+#include <string>
+#include <vector>
+
+struct KeyEvent
+{
+    int key; // Index into ImGuiIO::KeysDown
+    bool down;
+};
+
+// One frame's worth of input, as fed to ImGuiIO right before ImGui::NewFrame()
+struct InputFrame
+{
+    float deltaTime = 0;
+    ImVec2 mousePos;
+    int mouseButtons = 0; // Bit i is set while mouse button i is held
+    float mouseWheel = 0;
+    int keyMods = 0; // Bits for ctrl, shift, alt, super, in that order
+
+    // Initialized too, so frames can be brace-initialized with only the fields before them
+    std::vector<KeyEvent> keyEvents = {};
+    std::vector<ImWchar> chars = {};
+
+    std::string levelPath = {}; // Level that got loaded during this frame, if any
+};
+
+struct InputScript
+{
+    ImVec2 displaySize;
+    std::string iniSettings; // Window layout when recording started, so widgets end up in the same place
+    std::vector<int> keysDownAtStart; // Held when recording started, since frames only log key changes
+    std::vector<InputFrame> frames;
+};
+
+InputScript loadInputScript(const std::string& filename);
+void saveInputScript(const std::string& filename, const InputScript& script);
+
+// Feeds a script to ImGui one frame at a time. It tracks the script's key state itself, since frames only hold
+// key changes, and overwrites all of io's input with it, including any keys the platform backend put there.
+class InputPlayer
+{
+public:
+    void begin(const InputScript& script);
+    void applyFrame(ImGuiIO& io, const InputFrame& frame);
+
+private:
+    bool m_keysDown[512] = {};
+};
+
+// Logs what ImGui receives each frame, to be called between the platform backend's NewFrame and ImGui::NewFrame
+class InputRecorder
+{
+public:
+    void begin(const ImGuiIO& io);
+    void captureFrame(const ImGuiIO& io);
+    void noteLevelLoaded(const std::string& levelPath);
+
+    const InputScript& getScript() const { return m_script; }
+
+private:
+    InputScript m_script;
+    bool m_keysDown[512] = {};
+};
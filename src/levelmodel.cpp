@@ -0,0 +1,201 @@
+#include "levelmodel.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+size_t LevelObjects::addRow(ObjectId id, ObjectKind objKind)
+{
+    size_t row = size();
+    m_rowOfId.mut()[id] = row;
+    m_idOfRow.mut().push_back(id);
+
+    forEachColumn([](auto& column) { column.mut().emplace_back(); });
+    kind[row] = objKind;
+    m_kindCounts[static_cast<size_t>(objKind)]++;
+    return row;
+}
+
+ObjectId LevelObjects::add(ObjectKind objKind, const std::shared_ptr<Texture>& tex)
+{
+    ObjectId id = m_nextId++;
+    size_t row = addRow(id, objKind);
+    anchor[row] = ImVec2(0.5, 0.5);
+    scale[row] = 1;
+    cols[row] = 1;
+    span[row] = 1;
+    flags[row] = 0;
+    planetType[row] = PlanetType::NORMAL;
+    planetOrder[row] = PlanetOrder::MIDDLE;
+    setTexture(row, tex);
+
+    if (objKind == ObjectKind::FOOD) m_recipeOrder.mut().push_back(id);
+
+    return id;
+}
+
+void LevelObjects::remove(ObjectId id)
+{
+    if (!contains(id)) return;
+
+    size_t row = rowOf(id);
+    size_t lastRow = size() - 1;
+    auto& rowOfId = m_rowOfId.mut();
+    rowOfId.erase(id);
+
+    m_kindCounts[static_cast<size_t>(kind.get()[row])]--;
+    if (kind.get()[row] == ObjectKind::FOOD)
+    {
+        auto& recipe = m_recipeOrder.mut();
+        recipe.erase(std::find(recipe.begin(), recipe.end(), id));
+    }
+
+    // Swap and pop
+    if (row != lastRow)
+    {
+        forEachColumn([row, lastRow](auto& column) { column[row] = std::move(column[lastRow]); });
+        m_idOfRow[row] = m_idOfRow[lastRow];
+        rowOfId[m_idOfRow[row]] = row;
+    }
+    forEachColumn([](auto& column) { column.mut().pop_back(); });
+    m_idOfRow.mut().pop_back();
+}
+
+void LevelObjects::remove(const std::vector<ObjectId>& ids)
+{
+    std::vector<uint8_t> removed(size(), 0);
+    size_t firstRemoved = size();
+    for (ObjectId id : ids)
+    {
+        if (!contains(id)) continue;
+        size_t row = rowOf(id);
+        if (removed[row]) continue;
+        removed[row] = 1;
+        firstRemoved = std::min(firstRemoved, row);
+        m_kindCounts[static_cast<size_t>(kind.get()[row])]--;
+    }
+    if (firstRemoved == size()) return;
+
+    auto& recipe = m_recipeOrder.mut();
+    recipe.erase(std::remove_if(recipe.begin(), recipe.end(), [&](ObjectId id) { return removed[rowOf(id)]; }),
+                 recipe.end());
+
+    auto& rowOfId = m_rowOfId.mut();
+    for (size_t row = firstRemoved; row < size(); row++)
+    {
+        if (removed[row]) rowOfId.erase(m_idOfRow.get()[row]);
+    }
+
+    // Slide the rows that stay down over the gaps, in every column
+    auto compact = [&](auto& column) {
+        auto& values = column.mut();
+        size_t kept = firstRemoved;
+        for (size_t row = firstRemoved; row < values.size(); row++)
+        {
+            if (!removed[row]) values[kept++] = std::move(values[row]);
+        }
+        values.erase(values.begin() + kept, values.end());
+    };
+    forEachColumn(compact);
+    compact(m_idOfRow);
+
+    const auto& idOfRow = m_idOfRow.get();
+    for (size_t row = firstRemoved; row < idOfRow.size(); row++) rowOfId[idOfRow[row]] = row;
+}
+
+void LevelObjects::translate(const std::vector<size_t>& rows, ImVec2 delta)
+{
+    auto& positions = pos.mut();
+    for (size_t row : rows) positions[row] = ImVec2(positions[row].x + delta.x, positions[row].y + delta.y);
+}
+
+void LevelObjects::scaleAbout(const std::vector<size_t>& rows, ImVec2 pivot, float factor)
+{
+    auto& positions = pos.mut();
+    auto& scales = scale.mut();
+    for (size_t row : rows)
+    {
+        positions[row] = ImVec2(pivot.x + (positions[row].x - pivot.x) * factor,
+                                pivot.y + (positions[row].y - pivot.y) * factor);
+        scales[row] *= factor;
+    }
+}
+
+ObjectId LevelObjects::addCopy(ObjectId id)
+{
+    ObjectRecord rec = record(id);
+    rec.id = m_nextId; // restore() bumps m_nextId past it
+    rec.recipeStep = static_cast<uint32_t>(m_recipeOrder.get().size());
+    restore(rec);
+    return rec.id;
+}
+
+ObjectRecord LevelObjects::record(ObjectId id) const
+{
+    size_t row = rowOf(id);
+    const auto& recipe = m_recipeOrder.get();
+
+    ObjectRecord rec;
+    rec.id = id;
+    rec.kind = kind[row];
+    rec.pos = pos[row];
+    rec.anchor = anchor[row];
+    rec.scale = scale[row];
+    rec.texIndex = texIndex[row];
+    rec.cols = cols[row];
+    rec.span = span[row];
+    rec.flags = flags[row];
+    rec.planetType = planetType[row];
+    rec.planetOrder = planetOrder[row];
+    rec.recipeStep = 0;
+    if (rec.kind == ObjectKind::FOOD)
+    {
+        rec.recipeStep = static_cast<uint32_t>(std::find(recipe.begin(), recipe.end(), id) - recipe.begin());
+    }
+    return rec;
+}
+
+void LevelObjects::restore(const ObjectRecord& rec)
+{
+    size_t row = addRow(rec.id, rec.kind);
+    pos[row] = rec.pos;
+    anchor[row] = rec.anchor;
+    scale[row] = rec.scale;
+    texIndex[row] = rec.texIndex; // The texture table never shrinks, so the index is still good
+    cols[row] = rec.cols;
+    span[row] = rec.span;
+    flags[row] = rec.flags;
+    planetType[row] = rec.planetType;
+    planetOrder[row] = rec.planetOrder;
+
+    if (rec.kind == ObjectKind::FOOD)
+    {
+        auto& recipe = m_recipeOrder.mut();
+        size_t step = std::min(static_cast<size_t>(rec.recipeStep), recipe.size());
+        recipe.insert(recipe.begin() + step, rec.id);
+    }
+    m_nextId = std::max(m_nextId, rec.id + 1);
+}
+
+std::vector<size_t> LevelObjects::rowsOfKind(ObjectKind objKind) const
+{
+    std::vector<size_t> rows;
+    for (size_t row = 0; row < size(); row++)
+    {
+        if (kind[row] == objKind) rows.push_back(row);
+    }
+    return rows;
+}
+
+void LevelObjects::setTexture(size_t row, const std::shared_ptr<Texture>& tex)
+{
+    const auto& textures = m_textures.get();
+    auto it = std::find(textures.begin(), textures.end(), tex);
+    if (it == textures.end())
+    {
+        if (textures.size() > UINT16_MAX) throw std::runtime_error("Too many textures in one level");
+        m_textures.mut().push_back(tex);
+        texIndex[row] = static_cast<uint16_t>(m_textures.size() - 1);
+        return;
+    }
+    texIndex[row] = static_cast<uint16_t>(it - textures.begin());
+}
@@ -2,63 +2,140 @@
 
 #include "imgui.h"
 #include "assetman.h"
+#include "cow.h"
 
-#include <vector>
+#include <cstdint>
 #include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 enum class PlanetOrder { START, MIDDLE, END };
 enum class PlanetType { NORMAL, SUN, BLACKHOLE, STORAGE, SEASON };
 
-struct ObjectModel
+// Also the order hit tests prefer overlapping objects in: planets, then foods, then the customer and player
+enum class ObjectKind : uint8_t { PLANET, FOOD, CUSTOMER, PLAYER };
+
+// Bits in LevelObjects::flags
+enum ObjectFlags : unsigned int
 {
-    std::shared_ptr<Texture> tex;
-    float scale;
+    OBJECT_HAS_FOOD = 1 << 0,   // Planets
+    OBJECT_COOKABLE = 1 << 1,   // Foods
+    OBJECT_SEASONABLE = 1 << 2, // Foods
+};
+
+// Persistent ID of a level object. IDs are never reused within a level, so one still means the same object
+// after it's removed and brought back (by undo, say). NO_OBJECT is never a valid ID.
+using ObjectId = uint64_t;
+constexpr ObjectId NO_OBJECT = 0;
+
+// One object's whole row, for taking it out of the level and putting it back later with the same ID
+struct ObjectRecord
+{
+    ObjectId id;
+    ObjectKind kind;
     ImVec2 pos;
     ImVec2 anchor;
+    float scale;
+    uint16_t texIndex;
+    int cols;
+    int span;
+    unsigned int flags;
+    PlanetType planetType;
+    PlanetOrder planetOrder;
+    uint32_t recipeStep; // Only meaningful for foods
+};
+
+// Every object in a level, as parallel arrays indexed by row. Removing an object moves the last row into its
+// place, so rows aren't stable; hold on to ObjectIds across frames and look the row up when needed.
+// Row order means nothing, the recipe order of the foods is kept separately.
+//
+// Each column is copy-on-write, so copying a LevelObjects only copies pointers, and afterwards each copy only
+// pays for the columns it actually writes to.
+class LevelObjects
+{
+public:
+    ObjectId add(ObjectKind objKind, const std::shared_ptr<Texture>& tex);
+    void remove(ObjectId id);
+
+    // Batch edits for many objects at once. Each column is detached and walked once, instead of once per object.
+    void remove(const std::vector<ObjectId>& ids); // Keeps the remaining rows in order
+    void translate(const std::vector<size_t>& rows, ImVec2 delta);
+    void scaleAbout(const std::vector<size_t>& rows, ImVec2 pivot, float factor); // Spreads positions out too
+    ObjectId addCopy(ObjectId id); // New ID, same everything else. Foods go on the end of the recipe.
+
+    ObjectRecord record(ObjectId id) const; // id has to be valid
+    void restore(const ObjectRecord& rec); // rec.id must not be in the level already
 
-    int cols; // Columns of animation frames
-    int span; // Total animation frames
+    bool contains(ObjectId id) const { return m_rowOfId.get().find(id) != m_rowOfId.get().end(); }
+    size_t rowOf(ObjectId id) const { return m_rowOfId.get().find(id)->second; } // id has to be valid
+    ObjectId idAt(size_t row) const { return m_idOfRow[row]; }
+    size_t size() const { return kind.size(); }
+    size_t count(ObjectKind objKind) const { return m_kindCounts[static_cast<size_t>(objKind)]; }
 
-    inline ImVec2 frameSize()
+    // Rows of the given kind, in no particular order
+    std::vector<size_t> rowsOfKind(ObjectKind objKind) const;
+
+    // Every food, in the order the player has to collect them
+    const std::vector<ObjectId>& recipeOrder() const { return m_recipeOrder.get(); }
+    void swapRecipeSteps(size_t a, size_t b) { std::swap(m_recipeOrder[a], m_recipeOrder[b]); }
+
+    const std::shared_ptr<Texture>& texture(size_t row) const { return m_textures[texIndex[row]]; }
+    void setTexture(size_t row, const std::shared_ptr<Texture>& tex);
+
+    ImVec2 frameSize(size_t row) const
     {
-        int rows = span / cols;
-        if (span % cols != 0) rows++;
-        return ImVec2(static_cast<float>(tex->width) / cols,
-                      static_cast<float>(tex->height) / rows);
+        int rows = span[row] / cols[row];
+        if (span[row] % cols[row] != 0) rows++;
+        return ImVec2(static_cast<float>(texture(row)->width) / cols[row],
+                      static_cast<float>(texture(row)->height) / rows);
     }
 
-    inline ImVec2 uvEnd()
+    ImVec2 uvEnd(size_t row) const
     {
-        int rows = span / cols;
-        if (span % cols != 0) rows++;
-        return ImVec2(1.f / cols, 1.f / rows);
+        int rows = span[row] / cols[row];
+        if (span[row] % cols[row] != 0) rows++;
+        return ImVec2(1.f / cols[row], 1.f / rows);
     }
 
-    virtual ~ObjectModel() = default;
-};
+    // One entry per row. Edit values in place freely, but only add() and remove() should resize these.
+    CowColumn<ObjectKind> kind;
+    CowColumn<ImVec2> pos;
+    CowColumn<ImVec2> anchor;
+    CowColumn<float> scale;
+    CowColumn<uint16_t> texIndex;
+    CowColumn<int> cols; // Columns of animation frames
+    CowColumn<int> span; // Total animation frames
+    CowColumn<unsigned int> flags; // ObjectFlags
+    CowColumn<PlanetType> planetType; // Only meaningful for planets
+    CowColumn<PlanetOrder> planetOrder; // Only meaningful for planets
 
-struct PlanetModel : public ObjectModel
-{
-    bool hasFood;
-    PlanetType type;
-    PlanetOrder order;
-};
+private:
+    size_t addRow(ObjectId id, ObjectKind objKind);
 
-struct FoodModel : public ObjectModel
-{
-    bool cookable;
-    bool seasonable;
+    template <typename F>
+    void forEachColumn(F&& f)
+    {
+        f(kind); f(pos); f(anchor); f(scale); f(texIndex); f(cols); f(span); f(flags); f(planetType); f(planetOrder);
+    }
+
+    ObjectId m_nextId = 1;
+    Cow<std::unordered_map<ObjectId, size_t>> m_rowOfId;
+    CowColumn<ObjectId> m_idOfRow;
+    size_t m_kindCounts[4] = {};
+
+    CowColumn<ObjectId> m_recipeOrder;
+    CowColumn<std::shared_ptr<Texture>> m_textures; // Indexed by texIndex
 };
 
+// Copies are cheap snapshots (see LevelObjects), e.g. to save or analyze a frozen level on another thread
+// while the editor keeps changing the original.
 struct LevelModel {
     int levelNumber;
     float levelTimer;
 
-    std::vector<std::shared_ptr<PlanetModel>> planets;
-
-    std::vector<std::shared_ptr<FoodModel>> foods;
+    LevelObjects objects;
 
-    std::shared_ptr<ObjectModel> player;
-    std::shared_ptr<ObjectModel> customer;
+    ObjectId player = NO_OBJECT;
+    ObjectId customer = NO_OBJECT;
 };
-
@@ -1,4 +1,6 @@
 #include "loadjson.h"
+#include "alloctracker.h"
+#include "profiler.h"
 #include "global.h"
 
 #include "json.hpp"
@@ -32,7 +34,7 @@ void loadJsonAssets()
         {
             fs::path texPath = g_assetMan.getAssetPathRoot() / texJsonItem.value()["file"].get<std::string>();
             texPath.make_preferred();
-            g_assetMan.loadTexture(texPath, name);
+            g_assetMan.loadTextureAsync(texPath, name);
         }
     }
 }
@@ -50,56 +52,60 @@ ImVec2 loadJsonCoord(const json& coordJson)
     return ImVec2(scale, scale);
 }
 
-void loadObjectModel(const json& objectJson, std::shared_ptr<ObjectModel> objectModel)
+ObjectId loadObjectModel(const json& objectJson, ObjectKind kind, LevelObjects& objects)
 {
     auto texName = objectJson["data"]["texture"].get<std::string>();
-    objectModel->tex = g_assetMan.findTextureByShortName(texName);
-    objectModel->pos = loadJsonCoord(objectJson["data"]["position"]);
-    objectModel->anchor = loadJsonCoord(objectJson["data"]["anchor"]);
-    objectModel->scale = loadJsonCoord(objectJson["data"]["scale"]).x;
+    ObjectId id = objects.add(kind, g_assetMan.findTextureByShortName(texName));
+    size_t row = objects.rowOf(id);
 
-    objectModel->pos.y = -objectModel->pos.y; // Flip Y coordinate (little hacky but w/e)
+    objects.pos[row] = loadJsonCoord(objectJson["data"]["position"]);
+    objects.anchor[row] = loadJsonCoord(objectJson["data"]["anchor"]);
+    objects.scale[row] = loadJsonCoord(objectJson["data"]["scale"]).x;
 
-    objectModel->cols = getJsonDefault(objectJson["data"], "cols", 1);
-    objectModel->span = getJsonDefault(objectJson["data"], "span", objectModel->cols);
+    objects.pos[row].y = -objects.pos[row].y; // Flip Y coordinate (little hacky but w/e)
+
+    objects.cols[row] = getJsonDefault(objectJson["data"], "cols", 1);
+    objects.span[row] = getJsonDefault(objectJson["data"], "span", objects.cols[row]);
+
+    return id;
 }
 
-std::shared_ptr<PlanetModel> loadJsonPlanet(const json& planetJson)
+ObjectId loadJsonPlanet(const json& planetJson, LevelObjects& objects)
 {
-    auto planetModel = std::make_shared<PlanetModel>();
+    ObjectId planet = loadObjectModel(planetJson, ObjectKind::PLANET, objects);
+    size_t row = objects.rowOf(planet);
 
-    loadObjectModel(planetJson, planetModel);
-
-    planetModel->hasFood = getJsonDefault(planetJson["data"], "hasFood", false);
+    if (getJsonDefault(planetJson["data"], "hasFood", false)) objects.flags[row] |= OBJECT_HAS_FOOD;
 
     bool isSun = getJsonDefault(planetJson["data"], "isSun", false);
     bool isBlackHole = getJsonDefault(planetJson["data"], "isBlackHole", false);
     bool isStorage = getJsonDefault(planetJson["data"], "isStorage", false);
     bool isSeason = getJsonDefault(planetJson["data"], "isSeasonPlanet", false);
 
-    if (isSun) planetModel->type = PlanetType::SUN;
-    else if (isBlackHole) planetModel->type = PlanetType::BLACKHOLE;
-    else if (isStorage) planetModel->type = PlanetType::STORAGE;
-    else if (isSeason) planetModel->type = PlanetType::SEASON;
-    else planetModel->type = PlanetType::NORMAL;
+    if (isSun) objects.planetType[row] = PlanetType::SUN;
+    else if (isBlackHole) objects.planetType[row] = PlanetType::BLACKHOLE;
+    else if (isStorage) objects.planetType[row] = PlanetType::STORAGE;
+    else if (isSeason) objects.planetType[row] = PlanetType::SEASON;
+    else objects.planetType[row] = PlanetType::NORMAL;
 
-    return planetModel;
+    return planet;
 }
 
-std::shared_ptr<FoodModel> loadJsonFood(const json& foodJson)
+ObjectId loadJsonFood(const json& foodJson, LevelObjects& objects)
 {
-    auto foodModel = std::make_shared<FoodModel>();
-
-    loadObjectModel(foodJson, foodModel);
+    ObjectId food = loadObjectModel(foodJson, ObjectKind::FOOD, objects);
+    size_t row = objects.rowOf(food);
 
-    foodModel->cookable = getJsonDefault(foodJson["data"], "cookable", false);
-    foodModel->seasonable = getJsonDefault(foodJson["data"], "seasonable", false);
+    if (getJsonDefault(foodJson["data"], "cookable", false)) objects.flags[row] |= OBJECT_COOKABLE;
+    if (getJsonDefault(foodJson["data"], "seasonable", false)) objects.flags[row] |= OBJECT_SEASONABLE;
 
-    return foodModel;
+    return food;
 }
 
 std::shared_ptr<LevelModel> loadJsonLevel(const std::string& filename)
 {
+    PROFILE_ZONE("loadJsonLevel");
+    ALLOC_SCOPE(AllocTag::JSON_LOAD);
     loadJsonAssets();
 
     std::ifstream f(filename);
@@ -116,38 +122,36 @@ std::shared_ptr<LevelModel> loadJsonLevel(const std::string& filename)
     auto& planetMapJson = levelJson["scenes"][levelNumStr]["children"]["game"]["children"]["planets"]["children"];
     for (auto& planetJsonItem : planetMapJson.items())
     {
-        auto planet = loadJsonPlanet(planetJsonItem.value());
+        ObjectId planet = loadJsonPlanet(planetJsonItem.value(), levelModel->objects);
+        PlanetOrder& order = levelModel->objects.planetOrder[levelModel->objects.rowOf(planet)];
         if (planetJsonItem.key() == "startPlanet")
         {
-            planet->order = PlanetOrder::START;
+            order = PlanetOrder::START;
         }
         else if (planetJsonItem.key() == "endPlanet")
         {
-            planet->order = PlanetOrder::END;
+            order = PlanetOrder::END;
         }
         else
         {
-            planet->order = PlanetOrder::MIDDLE;
+            order = PlanetOrder::MIDDLE;
         }
-        levelModel->planets.emplace_back(planet);
     }
 
     // Load foods
     auto& foodMapJson = levelJson["scenes"][levelNumStr]["children"]["game"]["children"]["food"]["children"];
     for (auto& foodJsonItem : foodMapJson.items())
     {
-        levelModel->foods.emplace_back(loadJsonFood(foodJsonItem.value()));
+        loadJsonFood(foodJsonItem.value(), levelModel->objects);
     }
 
     // Load player
     auto& playerJson = levelJson["scenes"][levelNumStr]["children"]["game"]["children"]["player"];
-    levelModel->player = std::make_shared<ObjectModel>();
-    loadObjectModel(playerJson, levelModel->player);
+    levelModel->player = loadObjectModel(playerJson, ObjectKind::PLAYER, levelModel->objects);
 
     // Load customer
     auto& customerJson = levelJson["scenes"][levelNumStr]["children"]["game"]["children"]["customer"];
-    levelModel->customer = std::make_shared<ObjectModel>();
-    loadObjectModel(customerJson, levelModel->customer);
+    levelModel->customer = loadObjectModel(customerJson, ObjectKind::CUSTOMER, levelModel->objects);
 
     // Load level timer
     auto& timerJson = levelJson["scenes"][levelNumStr]["children"]["game"]["children"]["timer"]["data"]["timer"];
@@ -2,11 +2,26 @@
 // If you are new to dear imgui, see examples/README.txt and documentation at the top of imgui.cpp.
 // (GLFW is a cross-platform general purpose library for handling windows, inputs, OpenGL/Vulkan/Metal graphics context creation, etc.)
 
+#include "alloctracker.h"
 #include "editor.h"
+#include "framestats.h"
+#include "glgridrenderer.h"
+#include "global.h"
+#include "glspriterenderer.h"
+#include "gltextureuploader.h"
+#include "inputscript.h"
+#include "profiler.h"
+#include "visualizer.h"
 #include "imgui.h"
 #include "imgui_impl_glfw.h"
 #include "imgui_impl_opengl3.h"
 #include <stdio.h>
+#include <ctype.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <string>
+#include <vector>
 
 // About Desktop OpenGL function loaders:
 //  Modern desktop OpenGL doesn't have a standard portable header file to load OpenGL function pointers.
@@ -47,8 +62,124 @@ static void glfw_error_callback(int error, const char* description)
   fprintf(stderr, "Glfw Error %d: %s\n", error, description);
 }
 
-int main(int, char**)
+// After input, keep drawing for a few frames so hover states and layout changes have time to settle
+static const int FRAMES_AFTER_INPUT = 3;
+
+// How often to wake up with no input. The text caret blinks, so that needs more frequent redraws.
+static const double IDLE_WAKE_INTERVAL = 5.0;
+static const double CARET_BLINK_INTERVAL = 0.4;
+
+static const double CPU_USAGE_REPORT_INTERVAL = 5.0;
+
+// Installed before ImGui's own callbacks, which chain to these
+static void onInputEvent() { g_redraw.requestFrames(FRAMES_AFTER_INPUT); }
+static void mouseButtonCallback(GLFWwindow*, int, int, int) { onInputEvent(); }
+static void scrollCallback(GLFWwindow*, double, double) { onInputEvent(); }
+static void keyCallback(GLFWwindow*, int, int, int, int) { onInputEvent(); }
+static void charCallback(GLFWwindow*, unsigned int) { onInputEvent(); }
+static void cursorPosCallback(GLFWwindow*, double, double) { onInputEvent(); }
+static void cursorEnterCallback(GLFWwindow*, int) { onInputEvent(); }
+static void windowFocusCallback(GLFWwindow*, int) { onInputEvent(); }
+static void windowRefreshCallback(GLFWwindow*) { onInputEvent(); }
+static void framebufferSizeCallback(GLFWwindow*, int, int) { onInputEvent(); }
+static void dropCallback(GLFWwindow*, int, const char**) { onInputEvent(); }
+
+static void installRedrawCallbacks(GLFWwindow* window)
+{
+  glfwSetMouseButtonCallback(window, mouseButtonCallback);
+  glfwSetScrollCallback(window, scrollCallback);
+  glfwSetKeyCallback(window, keyCallback);
+  glfwSetCharCallback(window, charCallback);
+  glfwSetCursorPosCallback(window, cursorPosCallback);
+  glfwSetCursorEnterCallback(window, cursorEnterCallback);
+  glfwSetWindowFocusCallback(window, windowFocusCallback);
+  glfwSetWindowRefreshCallback(window, windowRefreshCallback);
+  glfwSetFramebufferSizeCallback(window, framebufferSizeCallback);
+  glfwSetDropCallback(window, dropCallback);
+
+  g_redraw.setWakeCallback(glfwPostEmptyEvent);
+  g_redraw.requestFrames(FRAMES_AFTER_INPUT);
+}
+
+static void printUsage()
+{
+  printf("Usage: mwgeditor [options]\n"
+         "  --record <file>    Record all input (and loaded levels) to an input script\n"
+         "  --replay <file>    Replay an input script instead of taking live input\n"
+         "  --timings <file>   Write per-frame timings as CSV on exit\n"
+         "  --no-idle          Redraw at vsync even when nothing is happening\n"
+         "  --cpu-usage        Print this process's CPU usage every few seconds\n"
+         "  --undo-steps <n>   How many edits can be undone (default 200)\n"
+         "  --check-allocs     With --replay, replay twice and fail if the second run's frames allocate\n"
+         "                     (needs MWG_ALLOC_TRACKING)\n"
+         "  --trace <file>     Write profiler zones as a Chrome trace on exit (needs MWG_PROFILER)\n");
+}
+
+// Whole string has to be a non-negative number, unlike with std::stoul
+static bool parseCount(const char* text, size_t& count)
+{
+  if (!isdigit(static_cast<unsigned char>(text[0]))) return false;
+  char* end;
+  errno = 0;
+  unsigned long long value = strtoull(text, &end, 10);
+  if (*end != '\0' || errno == ERANGE) return false;
+  count = static_cast<size_t>(value);
+  return true;
+}
+
+int main(int argc, char** argv)
 {
+  std::string recordFile, replayFile, timingsFile, traceFile;
+  size_t undoSteps = g_undo.maxSteps();
+  bool idleRendering = true;
+  bool reportCpuUsage = false;
+  bool checkAllocs = false;
+  for (int i = 1; i < argc; i++)
+  {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+
+    if (arg == "--record" && hasValue) recordFile = argv[++i];
+    else if (arg == "--replay" && hasValue) replayFile = argv[++i];
+    else if (arg == "--timings" && hasValue) timingsFile = argv[++i];
+    else if (arg == "--trace" && hasValue) traceFile = argv[++i];
+    else if (arg == "--no-idle") idleRendering = false;
+    else if (arg == "--cpu-usage") reportCpuUsage = true;
+    else if (arg == "--check-allocs") checkAllocs = true;
+    else if (arg == "--undo-steps" && hasValue && parseCount(argv[i + 1], undoSteps)) i++;
+    else
+    {
+      printUsage();
+      return 1;
+    }
+  }
+  g_undo.setMaxSteps(undoSteps);
+  if (!traceFile.empty() && !PROFILER_ENABLED)
+  {
+    fprintf(stderr, "--trace needs a build configured with -DMWG_PROFILER=ON\n");
+    return 1;
+  }
+  if (checkAllocs && (replayFile.empty() || !ALLOC_TRACKING_ENABLED))
+  {
+    fprintf(stderr, "--check-allocs needs --replay and a build configured with -DMWG_ALLOC_TRACKING=ON\n");
+    return 1;
+  }
+
+  InputScript replayScript;
+  if (!replayFile.empty())
+  {
+    try
+    {
+      replayScript = loadInputScript(replayFile);
+    } catch (const std::exception& ex)
+    {
+      fprintf(stderr, "%s\n", ex.what());
+      return 1;
+    }
+  }
+  bool replaying = !replayFile.empty();
+  bool recording = !recordFile.empty();
+
   // Setup window
   glfwSetErrorCallback(glfw_error_callback);
   if (!glfwInit())
@@ -72,7 +203,9 @@ int main(int, char**)
 #endif
 
   // Create window with graphics context
-  GLFWwindow* window = glfwCreateWindow(1280, 720, "Milky Way Gourmet Level Editor", NULL, NULL);
+  int windowWidth = replaying ? static_cast<int>(replayScript.displaySize.x) : 1280;
+  int windowHeight = replaying ? static_cast<int>(replayScript.displaySize.y) : 720;
+  GLFWwindow* window = glfwCreateWindow(windowWidth, windowHeight, "Milky Way Gourmet Level Editor", NULL, NULL);
   if (window == NULL)
     return 1;
   glfwMakeContextCurrent(window);
@@ -102,6 +235,9 @@ int main(int, char**)
 
   // Setup Dear ImGui context
   IMGUI_CHECKVERSION();
+#ifdef MWG_ALLOC_TRACKING
+  ImGui::SetAllocatorFunctions(trackedMalloc, trackedFree);
+#endif
   ImGui::CreateContext();
   ImGuiIO& io = ImGui::GetIO(); (void)io;
   //io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;     // Enable Keyboard Controls
@@ -112,9 +248,31 @@ int main(int, char**)
   //ImGui::StyleColorsClassic();
 
   // Setup Platform/Renderer bindings
+  installRedrawCallbacks(window);
   ImGui_ImplGlfw_InitForOpenGL(window, true);
   ImGui_ImplOpenGL3_Init(glsl_version);
 
+  if (GlSpriteRenderer::isSupported())
+  {
+    try
+    {
+      setSpriteRenderer(std::make_unique<GlSpriteRenderer>(glsl_version));
+    } catch (const std::exception& ex)
+    {
+      fprintf(stderr, "%s\nFalling back to drawing sprites through ImGui\n", ex.what());
+    }
+  }
+  if (GlGridRenderer::isSupported())
+  {
+    try
+    {
+      setGridRenderer(std::make_unique<GlGridRenderer>(glsl_version));
+    } catch (const std::exception& ex)
+    {
+      fprintf(stderr, "%s\nFalling back to drawing the grid through ImGui\n", ex.what());
+    }
+  }
+
   // Load Fonts
   // - If no fonts are loaded, dear imgui will use the default font. You can also load multiple fonts and use ImGui::PushFont()/PopFont() to select them.
   // - AddFontFromFileTTF() will return the ImFont* so you can store it if you need to select the font among multiple.
@@ -135,38 +293,176 @@ int main(int, char**)
   bool show_another_window = false;
   ImVec4 clear_color = ImVec4(0.45f, 0.55f, 0.60f, 1.00f);
 
+  g_assetMan.setUploader(std::make_unique<GlTextureUploader>());
   initEditor();
 
+  if (replaying)
+  {
+    // Use the recorded layout, and leave the user's imgui.ini alone
+    io.IniFilename = NULL;
+    ImGui::LoadIniSettingsFromMemory(replayScript.iniSettings.c_str());
+  }
+  else if (recording && io.IniFilename)
+  {
+    // Load the layout now rather than in the first NewFrame() so the recording can capture it
+    ImGui::LoadIniSettingsFromDisk(io.IniFilename);
+  }
+
+  InputRecorder recorder;
+  InputPlayer player;
+  if (replaying) player.begin(replayScript);
+  // Only kept when something reads them at exit, so a normal session doesn't grow this forever
+  bool keepFrameStats = replaying || !timingsFile.empty();
+  std::vector<FrameStats> frameStats;
+  if (replaying) frameStats.reserve(replayScript.frames.size());
+  size_t frameIdx = 0;
+
+  // --check-allocs: once the script is done, start over from how things were before the first frame and replay
+  // it again. Everything those frames need was allocated the first time through, so anything they allocate is
+  // per-frame garbage. Like in mwgbench, frames that load a level or start an undo step are left out.
+  bool checkingAllocs = false;
+  ImVec2 startWorldPos = g_viz.getWorldPos();
+  float startZoom = g_viz.getZoom();
+  uint64_t steadyAllocs = 0;
+  size_t allocatingFrames = 0, checkedFrames = 0, skippedFrames = 0;
+
+  CpuUsageMeter cpuMeter;
+  int framesSinceCpuReport = 0;
+
   // Main loop
   while (!glfwWindowShouldClose(window))
   {
+    if (reportCpuUsage && cpuMeter.secondsSinceSample() >= CPU_USAGE_REPORT_INTERVAL)
+    {
+      double seconds = cpuMeter.secondsSinceSample();
+      printf("CPU usage: %.1f%% of a core, %d frames in %.1fs\n", cpuMeter.sample(), framesSinceCpuReport, seconds);
+      framesSinceCpuReport = 0;
+    }
+
     // Poll and handle events (inputs, window resize, etc.)
     // You can read the io.WantCaptureMouse, io.WantCaptureKeyboard flags to tell if dear imgui wants to use your inputs.
     // - When io.WantCaptureMouse is true, do not dispatch mouse input data to your main application.
     // - When io.WantCaptureKeyboard is true, do not dispatch keyboard input data to your main application.
     // Generally you may always pass all inputs to dear imgui, and hide them from your application based on those two flags.
-    glfwPollEvents();
+    // Drags and replays draw every frame, otherwise sleep until something happens.
+    bool continuous = !idleRendering || replaying || ImGui::IsAnyMouseDown() || g_redraw.hasWork();
+    if (continuous)
+    {
+      glfwPollEvents();
+    }
+    else
+    {
+      double timeout = io.WantTextInput ? CARET_BLINK_INTERVAL : IDLE_WAKE_INTERVAL;
+      if (reportCpuUsage) timeout = std::min(timeout, std::max(0.0, CPU_USAGE_REPORT_INTERVAL - cpuMeter.secondsSinceSample()));
+      glfwWaitEventsTimeout(timeout);
+
+      // Timed out with nothing to show, except maybe the caret blinking
+      if (!g_redraw.hasWork() && !io.WantTextInput) continue;
+    }
+    g_redraw.frameDrawn();
+    framesSinceCpuReport++;
+    PROFILE_ZONE("frame");
+    uint64_t allocsBefore = allocStatsSnapshot().total().count;
+    uint64_t undoStepsBefore = g_undo.stepsStarted();
 
     // Start the Dear ImGui frame
     ImGui_ImplOpenGL3_NewFrame();
     ImGui_ImplGlfw_NewFrame();
-    ImGui::NewFrame();
 
-    runEditor();
+    if (replaying)
+    {
+      if (frameIdx >= replayScript.frames.size())
+      {
+        if (!checkAllocs || checkingAllocs) break;
+        checkingAllocs = true;
+        frameIdx = 0;
+        g_level = nullptr; // The editor starts without one, the script loads it again
+        g_undo.clear();
+        g_selection.clear();
+        g_viz.setWorldPos(startWorldPos);
+        g_viz.setZoom(startZoom);
+        player.begin(replayScript);
+      }
+      io.DisplaySize = replayScript.displaySize;
+      player.applyFrame(io, replayScript.frames[frameIdx]);
+    }
+    if (recording)
+    {
+      if (frameIdx == 0) recorder.begin(io);
+      recorder.captureFrame(io);
+    }
+
+    auto levelBeforeFrame = g_level;
+    FrameStats stats = buildMeasuredFrame(runEditor);
+    if (keepFrameStats && !checkingAllocs) frameStats.push_back(stats);
+
+    if (recording && g_level != levelBeforeFrame) recorder.noteLevelLoaded(g_jsonFilename);
+    if (replaying)
+    {
+      try
+      {
+        replayLevelLoad(replayScript.frames[frameIdx].levelPath, levelBeforeFrame);
+      } catch (const std::exception& ex)
+      {
+        fprintf(stderr, "Could not load recorded level: %s\n", ex.what());
+        break;
+      }
+    }
+    bool loadedLevel = replaying && !replayScript.frames[frameIdx].levelPath.empty();
+    frameIdx++;
 
     // Rendering
-    ImGui::Render();
-    int display_w, display_h;
-    glfwGetFramebufferSize(window, &display_w, &display_h);
-    glViewport(0, 0, display_w, display_h);
-    glClearColor(clear_color.x, clear_color.y, clear_color.z, clear_color.w);
-    glClear(GL_COLOR_BUFFER_BIT);
-    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-
-    glfwSwapBuffers(window);
+    {
+      PROFILE_ZONE("render");
+      int display_w, display_h;
+      glfwGetFramebufferSize(window, &display_w, &display_h);
+      glViewport(0, 0, display_w, display_h);
+      glClearColor(clear_color.x, clear_color.y, clear_color.z, clear_color.w);
+      glClear(GL_COLOR_BUFFER_BIT);
+      ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    }
+
+    {
+      PROFILE_ZONE("swap");
+      glfwSwapBuffers(window);
+    }
+
+    if (checkingAllocs)
+    {
+      uint64_t allocs = allocStatsSnapshot().total().count - allocsBefore;
+      if (loadedLevel || g_undo.stepsStarted() != undoStepsBefore)
+      {
+        skippedFrames++;
+      }
+      else
+      {
+        checkedFrames++;
+        steadyAllocs += allocs;
+        if (allocs > 0) allocatingFrames++;
+      }
+    }
+  }
+
+  try
+  {
+    if (recording) saveInputScript(recordFile, recorder.getScript());
+    if (!timingsFile.empty()) saveFrameStatsCsv(timingsFile, frameStats);
+    if (!traceFile.empty()) saveChromeTrace(traceFile);
+  } catch (const std::exception& ex)
+  {
+    fprintf(stderr, "%s\n", ex.what());
+  }
+  if (replaying) printFrameStatsSummary(frameStats);
+  if (checkAllocs)
+  {
+    printf("replay: %llu heap allocations in %zu of %zu frames (%zu frames loading levels or starting undo steps left out)\n",
+           static_cast<unsigned long long>(steadyAllocs), allocatingFrames, checkedFrames, skippedFrames);
   }
 
   // Cleanup
+  // Free GL resources while there's still a context
+  setSpriteRenderer(std::make_unique<ImGuiSpriteRenderer>());
+  setGridRenderer(std::make_unique<ImGuiGridRenderer>());
   ImGui_ImplOpenGL3_Shutdown();
   ImGui_ImplGlfw_Shutdown();
   ImGui::DestroyContext();
@@ -174,5 +470,5 @@ int main(int, char**)
   glfwDestroyWindow(window);
   glfwTerminate();
 
-  return 0;
+  return checkAllocs && steadyAllocs > 0 ? 1 : 0;
 }
@@ -0,0 +1,171 @@
+#include "overlapdetector.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <cmath>
+
+static bool rectsOverlap(ImVec2 aMin, ImVec2 aMax, ImVec2 bMin, ImVec2 bMax)
+{
+    return aMin.x < bMax.x && bMin.x < aMax.x && aMin.y < bMax.y && bMin.y < aMax.y;
+}
+
+OverlapDetector::Box OverlapDetector::makeBox(const LevelObjects& objects, size_t row, float rangeRadiusPerScale)
+{
+    Box box;
+    box.id = objects.idAt(row);
+    box.active = objects.kind[row] == ObjectKind::PLANET || objects.kind[row] == ObjectKind::FOOD;
+    box.isPlanet = objects.kind[row] == ObjectKind::PLANET;
+    box.moved = false;
+
+    ImVec2 size(objects.frameSize(row).x * objects.scale[row], objects.frameSize(row).y * objects.scale[row]);
+    box.center = objects.pos[row];
+    box.spriteMin = ImVec2(box.center.x - size.x / 2, box.center.y - size.y / 2);
+    box.spriteMax = ImVec2(box.center.x + size.x / 2, box.center.y + size.y / 2);
+    box.bodyRadius = size.x / 2;
+    box.rangeRadius = box.isPlanet ? rangeRadiusPerScale * objects.scale[row] : 0;
+
+    float halfWidth = std::max(size.x / 2, box.rangeRadius), halfHeight = std::max(size.y / 2, box.rangeRadius);
+    box.min = ImVec2(box.center.x - halfWidth, box.center.y - halfHeight);
+    box.max = ImVec2(box.center.x + halfWidth, box.center.y + halfHeight);
+    return box;
+}
+
+bool OverlapDetector::sameBounds(const Box& a, const Box& b)
+{
+    return a.spriteMin.x == b.spriteMin.x && a.spriteMin.y == b.spriteMin.y && a.spriteMax.x == b.spriteMax.x &&
+           a.spriteMax.y == b.spriteMax.y && a.rangeRadius == b.rangeRadius;
+}
+
+void OverlapDetector::addPairIfOverlapping(uint32_t a, uint32_t b)
+{
+    const Box& boxA = m_boxes[a];
+    const Box& boxB = m_boxes[b];
+    if (!rectsOverlap(boxA.min, boxA.max, boxB.min, boxB.max)) return;
+
+    OverlapKind kind;
+    if (rectsOverlap(boxA.spriteMin, boxA.spriteMax, boxB.spriteMin, boxB.spriteMax))
+    {
+        kind = OverlapKind::SPRITES;
+    } else
+    {
+        if (!boxA.isPlanet || !boxB.isPlanet) return;
+        float dx = boxA.center.x - boxB.center.x, dy = boxA.center.y - boxB.center.y;
+        float dist = std::sqrt(dx * dx + dy * dy);
+        if (dist >= boxA.rangeRadius + boxB.bodyRadius && dist >= boxB.rangeRadius + boxA.bodyRadius) return;
+        kind = OverlapKind::IN_GRAVITY_RANGE;
+    }
+
+    if (boxA.id > boxB.id) std::swap(a, b);
+    m_pairs.push_back(OverlapPair{m_boxes[a].id, m_boxes[b].id, kind});
+    m_pairBoxes.emplace_back(a, b);
+}
+
+// Insertion sort, which is about linear when only a few boxes moved since last time
+void OverlapDetector::sortByLeftEdge()
+{
+    for (size_t i = 1; i < m_sorted.size(); i++)
+    {
+        uint32_t box = m_sorted[i];
+        float left = m_boxes[box].min.x;
+        size_t j = i;
+        for (; j > 0 && m_boxes[m_sorted[j - 1]].min.x > left; j--) m_sorted[j] = m_sorted[j - 1];
+        m_sorted[j] = box;
+    }
+}
+
+// Pairs between the box at m_sorted[sortedIdx] and the boxes it overlaps along x. A full sweep only needs to
+// look right, since every pair gets found from its left box. After a move, it looks both ways, and skips moved
+// boxes that will find the pair themselves.
+void OverlapDetector::sweep(uint32_t sortedIdx, bool onlyNewPairs)
+{
+    uint32_t box = m_sorted[sortedIdx];
+    const Box& self = m_boxes[box];
+
+    for (size_t j = sortedIdx + 1; j < m_sorted.size() && m_boxes[m_sorted[j]].min.x < self.max.x; j++)
+    {
+        uint32_t other = m_sorted[j];
+        if (onlyNewPairs && m_boxes[other].moved && other < box) continue;
+        addPairIfOverlapping(box, other);
+    }
+    if (!onlyNewPairs) return;
+
+    for (size_t j = sortedIdx; j > 0 && m_boxes[m_sorted[j - 1]].min.x > self.min.x - m_maxWidth; j--)
+    {
+        uint32_t other = m_sorted[j - 1];
+        if (m_boxes[other].moved && other < box) continue;
+        addPairIfOverlapping(box, other);
+    }
+}
+
+void OverlapDetector::rebuild(const LevelObjects& objects, float rangeRadiusPerScale)
+{
+    m_rangeRadiusPerScale = rangeRadiusPerScale;
+    m_boxes.clear();
+    m_sorted.clear();
+    m_maxWidth = 0;
+    for (size_t row = 0; row < objects.size(); row++)
+    {
+        m_boxes.push_back(makeBox(objects, row, rangeRadiusPerScale));
+        if (!m_boxes.back().active) continue;
+        m_sorted.push_back(static_cast<uint32_t>(row));
+        m_maxWidth = std::max(m_maxWidth, m_boxes.back().max.x - m_boxes.back().min.x);
+    }
+
+    std::sort(m_sorted.begin(), m_sorted.end(), [&](uint32_t a, uint32_t b) { return m_boxes[a].min.x < m_boxes[b].min.x; });
+    m_pairs.clear();
+    m_pairBoxes.clear();
+    for (uint32_t i = 0; i < m_sorted.size(); i++) sweep(i, false);
+    m_lastSwept = m_sorted.size();
+}
+
+void OverlapDetector::update(const LevelObjects& objects, float rangeRadiusPerScale)
+{
+    PROFILE_ZONE("OverlapDetector::update");
+    m_lastSwept = 0;
+
+    // Adding or removing objects moves rows around, so that starts over. It doesn't happen mid-drag.
+    if (objects.size() != m_boxes.size() || rangeRadiusPerScale != m_rangeRadiusPerScale)
+    {
+        rebuild(objects, rangeRadiusPerScale);
+        return;
+    }
+
+    bool anyMoved = false;
+    for (size_t row = 0; row < objects.size(); row++)
+    {
+        if (m_boxes[row].id != objects.idAt(row))
+        {
+            rebuild(objects, rangeRadiusPerScale);
+            return;
+        }
+
+        Box box = makeBox(objects, row, rangeRadiusPerScale);
+        if (!box.active || sameBounds(box, m_boxes[row])) continue;
+        box.moved = true;
+        m_boxes[row] = box;
+        m_maxWidth = std::max(m_maxWidth, box.max.x - box.min.x);
+        anyMoved = true;
+    }
+    if (!anyMoved) return;
+
+    // Moved boxes lose their pairs and find them again
+    size_t kept = 0;
+    for (size_t i = 0; i < m_pairs.size(); i++)
+    {
+        if (m_boxes[m_pairBoxes[i].first].moved || m_boxes[m_pairBoxes[i].second].moved) continue;
+        m_pairs[kept] = m_pairs[i];
+        m_pairBoxes[kept] = m_pairBoxes[i];
+        kept++;
+    }
+    m_pairs.resize(kept);
+    m_pairBoxes.resize(kept);
+
+    sortByLeftEdge();
+    for (uint32_t i = 0; i < m_sorted.size(); i++)
+    {
+        if (!m_boxes[m_sorted[i]].moved) continue;
+        sweep(i, true);
+        m_lastSwept++;
+    }
+    for (uint32_t box : m_sorted) m_boxes[box].moved = false;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "levelmodel.h"
+
+#include "imgui.h"
+
+#include <cstdint>
+#include <vector>
+
+enum class OverlapKind
+{
+    SPRITES, // Two planets or foods whose sprites' AABBs overlap
+    IN_GRAVITY_RANGE, // A planet's sprite reaches into another planet's gravity range
+};
+
+struct OverlapPair
+{
+    ObjectId a;
+    ObjectId b;
+    OverlapKind kind;
+};
+
+// Overlapping planets and foods, kept up to date with sweep and prune. Objects stay sorted by the left edge of
+// their bounds (a planet's include its gravity range), which barely changes from one frame to the next, so
+// re-sorting is nearly free. Only objects that moved get swept for new pairs; the rest keep theirs.
+class OverlapDetector
+{
+public:
+    // Cheap when little has moved, so call it every frame. rangeRadiusPerScale is the gravity range's radius
+    // at scale 1.
+    void update(const LevelObjects& objects, float rangeRadiusPerScale);
+
+    const std::vector<OverlapPair>& pairs() const { return m_pairs; }
+
+    // Objects swept for pairs in the last update(), everything after a full rebuild
+    size_t lastSwept() const { return m_lastSwept; }
+
+private:
+    struct Box
+    {
+        ObjectId id;
+        bool active; // Planets and foods; the rest only have a box so boxes line up with rows
+        bool isPlanet;
+        bool moved;
+        ImVec2 spriteMin;
+        ImVec2 spriteMax;
+        ImVec2 min; // Sprite and gravity range together
+        ImVec2 max;
+        ImVec2 center;
+        float bodyRadius;
+        float rangeRadius; // 0 for foods
+    };
+
+    static Box makeBox(const LevelObjects& objects, size_t row, float rangeRadiusPerScale);
+    static bool sameBounds(const Box& a, const Box& b);
+
+    void rebuild(const LevelObjects& objects, float rangeRadiusPerScale);
+    void sortByLeftEdge();
+    void sweep(uint32_t sortedIdx, bool onlyNewPairs);
+    void addPairIfOverlapping(uint32_t a, uint32_t b);
+
+    std::vector<Box> m_boxes; // One per row of the level
+    std::vector<uint32_t> m_sorted; // Active boxes, by min.x
+    float m_maxWidth = 0; // Widest box, bounds how far left a sweep has to look
+
+    std::vector<OverlapPair> m_pairs;
+    std::vector<std::pair<uint32_t, uint32_t>> m_pairBoxes; // Same order as m_pairs
+
+    float m_rangeRadiusPerScale = -1;
+    size_t m_lastSwept = 0;
+};
@@ -0,0 +1,149 @@
+#include "profiler.h"
+
+#include <stdexcept>
+
+#ifdef MWG_PROFILER
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+
+// Per thread, so about 2MB each
+static constexpr uint64_t ZONES_PER_THREAD = 1 << 16;
+
+// Fields are atomics so a reader racing with the writer wrapping around just sees a torn zone, which
+// profilerCollect() then throws out, rather than that being undefined behavior
+struct ZoneSlot
+{
+    std::atomic<const char*> name;
+    std::atomic<uint64_t> startNs;
+    std::atomic<uint64_t> endNs;
+    std::atomic<uint32_t> depth;
+};
+
+struct ThreadBuffer
+{
+    explicit ThreadBuffer(uint32_t threadIndex): threadIndex{threadIndex}, slots{new ZoneSlot[ZONES_PER_THREAD]} {}
+
+    uint32_t threadIndex;
+    std::unique_ptr<ZoneSlot[]> slots;
+    std::atomic<uint64_t> written{0}; // Total zones ever written, only the owning thread changes it
+    uint32_t openZones = 0; // Only touched by the owning thread
+};
+
+static const auto s_startTime = std::chrono::steady_clock::now();
+
+// Buffers outlive their threads, so zones from finished background jobs can still be looked at
+static std::mutex s_buffersMutex;
+static std::vector<std::unique_ptr<ThreadBuffer>> s_buffers;
+static thread_local ThreadBuffer* t_buffer = nullptr;
+
+static ThreadBuffer& threadBuffer()
+{
+    if (!t_buffer)
+    {
+        std::lock_guard<std::mutex> lock(s_buffersMutex);
+        s_buffers.push_back(std::make_unique<ThreadBuffer>(static_cast<uint32_t>(s_buffers.size())));
+        t_buffer = s_buffers.back().get();
+    }
+    return *t_buffer;
+}
+
+uint64_t profilerNowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - s_startTime).count();
+}
+
+ProfileZone::ProfileZone(const char* name): m_name{name}, m_startNs{profilerNowNs()}, m_depth{threadBuffer().openZones++} {}
+
+ProfileZone::~ProfileZone()
+{
+    uint64_t endNs = profilerNowNs();
+    ThreadBuffer& buffer = *t_buffer;
+    buffer.openZones--;
+
+    uint64_t idx = buffer.written.load(std::memory_order_relaxed);
+    ZoneSlot& slot = buffer.slots[idx % ZONES_PER_THREAD];
+    slot.name.store(m_name, std::memory_order_relaxed);
+    slot.startNs.store(m_startNs, std::memory_order_relaxed);
+    slot.endNs.store(endNs, std::memory_order_relaxed);
+    slot.depth.store(m_depth, std::memory_order_relaxed);
+    buffer.written.store(idx + 1, std::memory_order_release);
+}
+
+static void collectThread(const ThreadBuffer& buffer, uint64_t sinceNs, std::vector<ProfileZoneRecord>& zones)
+{
+    uint64_t written = buffer.written.load(std::memory_order_acquire);
+    uint64_t oldest = written > ZONES_PER_THREAD ? written - ZONES_PER_THREAD : 0;
+
+    // Newest first. Zones are written as they finish, so once one finished too early, all older ones did too.
+    uint64_t idx = written;
+    for (; idx > oldest; idx--)
+    {
+        const ZoneSlot& slot = buffer.slots[(idx - 1) % ZONES_PER_THREAD];
+        ProfileZoneRecord zone{slot.name.load(std::memory_order_relaxed), slot.startNs.load(std::memory_order_relaxed),
+                               slot.endNs.load(std::memory_order_relaxed), slot.depth.load(std::memory_order_relaxed)};
+        if (zone.endNs < sinceNs) break;
+        zones.push_back(zone);
+    }
+    std::reverse(zones.begin(), zones.end());
+
+    // Drop anything the owner might have overwritten while we were reading. That includes zone
+    // writtenAfter - ZONES_PER_THREAD, whose slot the next zone to finish could be halfway through writing.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t writtenAfter = buffer.written.load(std::memory_order_relaxed);
+    uint64_t safeFrom = writtenAfter >= ZONES_PER_THREAD ? writtenAfter - ZONES_PER_THREAD + 1 : 0;
+    if (safeFrom > idx) zones.erase(zones.begin(), zones.begin() + std::min<uint64_t>(safeFrom - idx, zones.size()));
+}
+
+void profilerCollect(std::vector<ProfileThreadZones>& threads, uint64_t sinceNs)
+{
+    std::lock_guard<std::mutex> lock(s_buffersMutex);
+
+    threads.resize(s_buffers.size());
+    for (size_t i = 0; i < s_buffers.size(); i++)
+    {
+        threads[i].threadIndex = s_buffers[i]->threadIndex;
+        threads[i].zones.clear();
+        collectThread(*s_buffers[i], sinceNs, threads[i].zones);
+    }
+}
+
+void saveChromeTrace(const std::string& filename)
+{
+    std::ofstream trace(filename);
+    if (!trace) throw std::runtime_error("Could not write trace: " + filename);
+
+    // Complete ("X") events in microseconds. Zone names are string literals from our own code, so they
+    // don't need escaping.
+    trace << std::fixed << std::setprecision(3);
+    trace << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    std::vector<ProfileThreadZones> threads;
+    profilerCollect(threads);
+
+    bool first = true;
+    for (const ProfileThreadZones& thread : threads)
+    {
+        for (const ProfileZoneRecord& zone : thread.zones)
+        {
+            if (!first) trace << ",\n";
+            first = false;
+            trace << "{\"name\":\"" << zone.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread.threadIndex
+                  << ",\"ts\":" << zone.startNs / 1000.0 << ",\"dur\":" << (zone.endNs - zone.startNs) / 1000.0 << "}";
+        }
+    }
+    trace << "\n]}\n";
+}
+
+#else
+
+void saveChromeTrace(const std::string&)
+{
+    throw std::runtime_error("Built without the profiler, configure with -DMWG_PROFILER=ON");
+}
+
+#endif
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Scoped CPU zones, for finding out where a frame's time goes. Only does anything in builds configured with
+// -DMWG_PROFILER=ON; otherwise PROFILE_ZONE compiles to nothing.
+//
+// Each thread writes its finished zones into its own ring buffer, so recording never takes a lock or waits on
+// another thread. The oldest zones get overwritten once a buffer fills up.
+//
+//     void loadStuff()
+//     {
+//         PROFILE_ZONE("loadStuff"); // Lasts until the end of the enclosing block
+//         ...
+//     }
+
+#ifdef MWG_PROFILER
+
+constexpr bool PROFILER_ENABLED = true;
+
+struct ProfileZoneRecord
+{
+    const char* name;
+    uint64_t startNs; // Since the profiler started
+    uint64_t endNs;
+    uint32_t depth; // Zones open around this one on the same thread
+};
+
+struct ProfileThreadZones
+{
+    uint32_t threadIndex; // In the order threads first recorded a zone, so the main thread is usually 0
+    std::vector<ProfileZoneRecord> zones; // In the order they finished, so children come before their parents
+};
+
+uint64_t profilerNowNs();
+
+// Copies every zone still in the buffers that finished at or after sinceNs into threads, reusing its storage.
+// Safe to call from any thread while the others keep recording.
+void profilerCollect(std::vector<ProfileThreadZones>& threads, uint64_t sinceNs = 0);
+
+class ProfileZone
+{
+public:
+    explicit ProfileZone(const char* name); // name has to outlive the profiler, so pretty much a string literal
+    ~ProfileZone();
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+    const char* m_name;
+    uint64_t m_startNs;
+    uint32_t m_depth;
+};
+
+#define PROFILE_ZONE_CONCAT2(a, b) a##b
+#define PROFILE_ZONE_CONCAT(a, b) PROFILE_ZONE_CONCAT2(a, b)
+#define PROFILE_ZONE(name) ProfileZone PROFILE_ZONE_CONCAT(profileZone, __LINE__)(name)
+
+#else
+
+constexpr bool PROFILER_ENABLED = false;
+
+#define PROFILE_ZONE(name) ((void)0)
+
+#endif
+
+// Writes every recorded zone in Chrome's trace event format, for chrome://tracing or https://ui.perfetto.dev.
+// Throws if the profiler isn't built in.
+void saveChromeTrace(const std::string& filename);
@@ -0,0 +1,141 @@
+#include "profilerview.h"
+#include "profiler.h"
+
+#ifdef MWG_PROFILER
+
+#include "imgui.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+static const float ROW_HEIGHT = 18;
+
+// Zones overlapping the last top-level zone that finished on this thread, which for the editor is the
+// previous frame
+static bool collectLastFrame(std::vector<ProfileThreadZones>& threads, uint64_t& startNs, uint64_t& endNs)
+{
+    // A frame at 10fps is 100ms, anything slower than that gets cut off on the left
+    constexpr uint64_t LOOKBACK_NS = 100'000'000;
+    uint64_t now = profilerNowNs();
+    profilerCollect(threads, now > LOOKBACK_NS ? now - LOOKBACK_NS : 0);
+
+    // The first thread to record anything, normally the one running the UI
+    if (threads.empty()) return false;
+    const std::vector<ProfileZoneRecord>& uiZones = threads[0].zones;
+    auto lastTopLevel = std::find_if(uiZones.rbegin(), uiZones.rend(), [](auto& zone) { return zone.depth == 0; });
+    if (lastTopLevel == uiZones.rend()) return false;
+
+    startNs = lastTopLevel->startNs;
+    endNs = lastTopLevel->endNs;
+    return endNs > startNs;
+}
+
+static ImU32 zoneColor(const char* name)
+{
+    // Stable color per name, so the same zone is easy to spot from frame to frame
+    unsigned int hash = 2166136261u;
+    for (const char* c = name; *c; c++) hash = (hash ^ static_cast<unsigned char>(*c)) * 16777619u;
+    float hue = (hash % 360) / 360.f;
+    float r, g, b;
+    ImGui::ColorConvertHSVtoRGB(hue, 0.5f, 0.7f, r, g, b);
+    return ImGui::GetColorU32(ImVec4(r, g, b, 1));
+}
+
+static void showThreadFlames(const ProfileThreadZones& thread, uint64_t startNs, uint64_t endNs)
+{
+    uint32_t maxDepth = 0;
+    for (auto& zone : thread.zones)
+    {
+        if (zone.endNs >= startNs && zone.startNs <= endNs) maxDepth = std::max(maxDepth, zone.depth);
+    }
+
+    ImGui::Text("Thread %u", thread.threadIndex);
+    ImVec2 origin = ImGui::GetCursorScreenPos();
+    float width = std::max(ImGui::GetContentRegionAvail().x, 1.f);
+    float height = (maxDepth + 1) * ROW_HEIGHT;
+    ImGui::PushID(static_cast<int>(thread.threadIndex));
+    ImGui::InvisibleButton("flames", ImVec2(width, height));
+    ImGui::PopID();
+    bool hovered = ImGui::IsItemHovered();
+    ImVec2 mouse = ImGui::GetIO().MousePos;
+
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    double pxPerNs = width / static_cast<double>(endNs - startNs);
+    for (auto& zone : thread.zones)
+    {
+        if (zone.endNs < startNs || zone.startNs > endNs) continue;
+
+        float x0 = origin.x + static_cast<float>((std::max(zone.startNs, startNs) - startNs) * pxPerNs);
+        float x1 = origin.x + static_cast<float>((std::min(zone.endNs, endNs) - startNs) * pxPerNs);
+        float y0 = origin.y + zone.depth * ROW_HEIGHT;
+        ImVec2 min(x0, y0);
+        ImVec2 max(std::max(x1, x0 + 1), y0 + ROW_HEIGHT - 1);
+
+        drawList->AddRectFilled(min, max, zoneColor(zone.name));
+        if (max.x - min.x > 20)
+        {
+            drawList->PushClipRect(min, max, true);
+            drawList->AddText(ImVec2(min.x + 3, min.y + 2), IM_COL32_WHITE, zone.name);
+            drawList->PopClipRect();
+        }
+
+        if (hovered && mouse.x >= min.x && mouse.x < max.x && mouse.y >= min.y && mouse.y < max.y)
+        {
+            ImGui::SetTooltip("%s\n%.3f ms", zone.name, (zone.endNs - zone.startNs) / 1e6);
+        }
+    }
+}
+
+void showProfilerWindow()
+{
+    static bool s_paused = false;
+    static std::vector<ProfileThreadZones> s_threads;
+    static uint64_t s_startNs = 0, s_endNs = 0;
+    static std::string s_traceMsg;
+
+    ImGui::SetNextWindowSize(ImVec2(700, 250), ImGuiCond_FirstUseEver);
+    ImGui::Begin("Profiler");
+
+    ImGui::Checkbox("Pause", &s_paused);
+    ImGui::SameLine();
+    if (ImGui::Button("Save trace"))
+    {
+        try
+        {
+            saveChromeTrace("trace.json");
+            s_traceMsg = "Saved trace.json";
+        } catch (const std::exception& ex)
+        {
+            s_traceMsg = ex.what();
+        }
+    }
+    if (!s_traceMsg.empty())
+    {
+        ImGui::SameLine();
+        ImGui::Text("%s", s_traceMsg.c_str());
+    }
+
+    bool haveFrame = s_endNs > s_startNs;
+    if (!s_paused) haveFrame = collectLastFrame(s_threads, s_startNs, s_endNs);
+    if (!haveFrame)
+    {
+        ImGui::Text("Nothing recorded yet");
+        ImGui::End();
+        return;
+    }
+
+    ImGui::Text("Last frame: %.3f ms", (s_endNs - s_startNs) / 1e6);
+    for (auto& thread : s_threads)
+    {
+        // Skip threads that weren't doing anything during the frame
+        bool active = std::any_of(thread.zones.begin(), thread.zones.end(), [](auto& zone) {
+            return zone.endNs >= s_startNs && zone.startNs <= s_endNs;
+        });
+        if (active) showThreadFlames(thread, s_startNs, s_endNs);
+    }
+
+    ImGui::End();
+}
+
+#endif
@@ -0,0 +1,6 @@
+#pragma once
+
+#ifdef MWG_PROFILER
+// Flame view of the last frame's profiler zones, on every thread that was busy during it
+void showProfilerWindow();
+#endif
@@ -0,0 +1,305 @@
+#include "reachability.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <future>
+#include <thread>
+
+// Counting sort of edges into adjacency lists: the edges out of node i end up in
+// edges[start[i]] up to edges[start[i + 1]]
+static void buildAdjacency(size_t nodes, const std::vector<std::pair<uint32_t, uint32_t>>& edgeList,
+                           std::vector<uint32_t>& start, std::vector<uint32_t>& edges)
+{
+    start.assign(nodes + 1, 0);
+    for (auto& edge : edgeList) start[edge.first + 1]++;
+    for (size_t i = 1; i < start.size(); i++) start[i] += start[i - 1];
+    edges.resize(edgeList.size());
+    for (auto& edge : edgeList) edges[start[edge.first]++] = edge.second;
+    for (size_t i = nodes; i > 0; i--) start[i] = start[i - 1];
+    start[0] = 0;
+}
+
+void ReachabilityAnalyzer::buildGraph()
+{
+    // For each planet, only the ones close enough in x can possibly be in reach
+    m_edgeList.clear();
+    for (uint32_t a = 0; a < m_planets.size(); a++)
+    {
+        const Planet& pa = m_planets[a];
+        for (uint32_t b = a + 1; b < m_planets.size(); b++)
+        {
+            const Planet& pb = m_planets[b];
+            if (pb.x - pa.x >= m_maxReach + m_maxRange) break;
+
+            float dx = pb.x - pa.x, dy = pb.y - pa.y;
+            float dist = std::sqrt(dx * dx + dy * dy);
+            if (dist < pa.reach + pb.range) m_edgeList.emplace_back(a, b);
+            if (dist < pb.reach + pa.range) m_edgeList.emplace_back(b, a);
+        }
+    }
+
+    buildAdjacency(m_planets.size(), m_edgeList, m_edgeStart, m_edges);
+}
+
+// Tarjan's algorithm, with an explicit stack so big levels can't overflow the real one
+void ReachabilityAnalyzer::findComponents()
+{
+    constexpr uint32_t UNVISITED = UINT32_MAX;
+    size_t count = m_planets.size();
+    m_visitIndex.assign(count, UNVISITED);
+    m_lowLink.assign(count, 0);
+    m_onStack.assign(count, 0);
+    m_component.assign(count, 0);
+    m_componentCount = 0;
+    m_stack.clear();
+    uint32_t nextIndex = 0;
+
+    auto visit = [&](uint32_t planet) {
+        m_visitIndex[planet] = m_lowLink[planet] = nextIndex++;
+        m_stack.push_back(planet);
+        m_onStack[planet] = 1;
+        m_callStack.emplace_back(planet, m_edgeStart[planet]);
+    };
+
+    for (uint32_t root = 0; root < count; root++)
+    {
+        if (m_visitIndex[root] != UNVISITED) continue;
+        visit(root);
+
+        while (!m_callStack.empty())
+        {
+            uint32_t planet = m_callStack.back().first;
+            uint32_t& nextEdge = m_callStack.back().second;
+            if (nextEdge < m_edgeStart[planet + 1])
+            {
+                uint32_t neighbour = m_edges[nextEdge++];
+                if (m_visitIndex[neighbour] == UNVISITED) visit(neighbour);
+                else if (m_onStack[neighbour]) m_lowLink[planet] = std::min(m_lowLink[planet], m_visitIndex[neighbour]);
+                continue;
+            }
+
+            // Done with everything reachable from planet, so it's the root of a component if nothing it
+            // reaches leads back further
+            if (m_lowLink[planet] == m_visitIndex[planet])
+            {
+                uint32_t member;
+                do
+                {
+                    member = m_stack.back();
+                    m_stack.pop_back();
+                    m_onStack[member] = 0;
+                    m_component[member] = m_componentCount;
+                } while (member != planet);
+                m_componentCount++;
+            }
+
+            m_callStack.pop_back();
+            if (!m_callStack.empty())
+            {
+                uint32_t caller = m_callStack.back().first;
+                m_lowLink[caller] = std::min(m_lowLink[caller], m_lowLink[planet]);
+            }
+        }
+    }
+
+    // Edges between components, reusing the planet edge list's storage
+    auto between = std::remove_if(m_edgeList.begin(), m_edgeList.end(), [&](auto& edge) {
+        return m_component[edge.first] == m_component[edge.second];
+    });
+    m_edgeList.erase(between, m_edgeList.end());
+    for (auto& edge : m_edgeList) edge = {m_component[edge.first], m_component[edge.second]};
+    buildAdjacency(m_componentCount, m_edgeList, m_componentEdgeStart, m_componentEdges);
+}
+
+uint32_t ReachabilityAnalyzer::planetAt(ImVec2 pos) const
+{
+    auto first = std::lower_bound(m_planets.begin(), m_planets.end(), pos.x - m_maxRange,
+                                  [](const Planet& planet, float x) { return planet.x < x; });
+
+    uint32_t nearest = NO_PLANET;
+    float nearestDistSq = 0;
+    for (auto it = first; it != m_planets.end() && it->x <= pos.x + m_maxRange; ++it)
+    {
+        float dx = it->x - pos.x, dy = it->y - pos.y;
+        float distSq = dx * dx + dy * dy;
+        if (distSq >= it->range * it->range) continue;
+        if (nearest == NO_PLANET || distSq < nearestDistSq)
+        {
+            nearest = static_cast<uint32_t>(it - m_planets.begin());
+            nearestDistSq = distSq;
+        }
+    }
+    return nearest;
+}
+
+// Breadth first search between the planets' components. With reachedOut it doesn't stop at `to`, so it can mark
+// every component that's reachable.
+bool ReachabilityAnalyzer::canGo(uint32_t from, uint32_t to, Search& search, std::vector<uint8_t>* reachedOut) const
+{
+    from = m_component[from];
+    to = m_component[to];
+    if (from == to && !reachedOut) return true;
+
+    if (search.visitStamp.size() != m_componentCount) search.visitStamp.assign(m_componentCount, 0);
+    uint32_t stamp = ++search.stamp;
+
+    search.queue.clear();
+    search.queue.push_back(from);
+    search.visitStamp[from] = stamp;
+    bool found = from == to;
+    for (size_t next = 0; next < search.queue.size() && (!found || reachedOut); next++)
+    {
+        uint32_t component = search.queue[next];
+        for (uint32_t e = m_componentEdgeStart[component]; e < m_componentEdgeStart[component + 1]; e++)
+        {
+            uint32_t neighbour = m_componentEdges[e];
+            if (search.visitStamp[neighbour] == stamp) continue;
+            search.visitStamp[neighbour] = stamp;
+            search.queue.push_back(neighbour);
+            found |= neighbour == to;
+        }
+    }
+
+    if (reachedOut)
+    {
+        reachedOut->assign(m_componentCount, 0);
+        for (uint32_t component : search.queue) (*reachedOut)[component] = 1;
+    }
+    return found;
+}
+
+void ReachabilityAnalyzer::analyze(const LevelObjects& objects, const ReachabilityParams& params, ReachabilityReport& out)
+{
+    PROFILE_ZONE("Reachability");
+    out.verdict = ReachVerdict::SOLVABLE;
+    out.recipeIndex = 0;
+    out.from = out.to = NO_OBJECT;
+    out.unreachablePlanets.clear();
+
+    m_planets.clear();
+    m_maxRange = m_maxReach = 0;
+    int starts = 0, ends = 0;
+    ObjectId startId = NO_OBJECT, endId = NO_OBJECT;
+    for (size_t row = 0; row < objects.size(); row++)
+    {
+        if (objects.kind[row] != ObjectKind::PLANET) continue;
+
+        float scale = objects.scale[row];
+        float range = params.rangeRadiusPerScale * scale;
+        float surface = objects.frameSize(row).x * scale / 2;
+        Planet planet{objects.pos[row].x, objects.pos[row].y, range, std::max(range, surface + params.jumpDistance),
+                      objects.idAt(row), (objects.flags[row] & OBJECT_HAS_FOOD) != 0};
+        m_planets.push_back(planet);
+        m_maxRange = std::max(m_maxRange, planet.range);
+        m_maxReach = std::max(m_maxReach, planet.reach);
+
+        if (objects.planetOrder[row] == PlanetOrder::START)
+        {
+            starts++;
+            startId = planet.id;
+        }
+        if (objects.planetOrder[row] == PlanetOrder::END)
+        {
+            ends++;
+            endId = planet.id;
+        }
+    }
+
+    if (starts != 1)
+    {
+        out.verdict = ReachVerdict::NO_START;
+        return;
+    }
+    if (ends != 1)
+    {
+        out.verdict = ReachVerdict::NO_END;
+        return;
+    }
+
+    std::sort(m_planets.begin(), m_planets.end(), [](const Planet& a, const Planet& b) { return a.x < b.x; });
+    buildGraph();
+    findComponents();
+
+    auto indexOf = [&](ObjectId id) {
+        auto it = std::find_if(m_planets.begin(), m_planets.end(), [id](const Planet& planet) { return planet.id == id; });
+        return static_cast<uint32_t>(it - m_planets.begin());
+    };
+
+    // The route the recipe makes the player take
+    m_legs.clear();
+    m_legs.push_back(indexOf(startId));
+    const std::vector<ObjectId>& recipe = objects.recipeOrder();
+    for (size_t i = 0; i < recipe.size(); i++)
+    {
+        uint32_t planet = planetAt(objects.pos[objects.rowOf(recipe[i])]);
+        if (planet == NO_PLANET)
+        {
+            out.verdict = ReachVerdict::FOOD_OFF_PLANET;
+            out.recipeIndex = i;
+            return;
+        }
+        m_legs.push_back(planet);
+    }
+    m_legs.push_back(indexOf(endId));
+
+    // The first leg also marks everything reachable from the start
+    size_t legCount = m_legs.size() - 1;
+    if (m_searches.empty()) m_searches.resize(1);
+    m_legOk.assign(legCount, 1);
+    m_legOk[0] = canGo(m_legs[0], m_legs[1], m_searches[0], &m_reachedFromStart);
+
+    // Legs within one component are fine already. The rest don't depend on each other, so they're searched
+    // in parallel.
+    m_openLegs.clear();
+    for (size_t i = 1; i < legCount; i++)
+    {
+        if (m_component[m_legs[i]] != m_component[m_legs[i + 1]]) m_openLegs.push_back(i);
+    }
+
+    constexpr size_t LEGS_PER_THREAD = 8;
+    size_t threads = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()),
+                                      (m_openLegs.size() + LEGS_PER_THREAD - 1) / LEGS_PER_THREAD);
+    if (m_searches.size() < threads) m_searches.resize(threads);
+
+    std::atomic<size_t> nextLeg{0};
+    auto work = [&](Search& search) {
+        for (size_t i = nextLeg++; i < m_openLegs.size(); i = nextLeg++)
+        {
+            size_t leg = m_openLegs[i];
+            m_legOk[leg] = canGo(m_legs[leg], m_legs[leg + 1], search, nullptr);
+        }
+    };
+
+    std::vector<std::future<void>> helpers;
+    for (size_t i = 1; i < threads; i++) helpers.push_back(std::async(std::launch::async, work, std::ref(m_searches[i])));
+    work(m_searches[0]);
+    for (auto& helper : helpers) helper.get();
+
+    for (uint32_t i = 0; i < m_planets.size(); i++)
+    {
+        if (!m_reachedFromStart[m_component[i]]) out.unreachablePlanets.push_back(m_planets[i].id);
+    }
+
+    auto firstBadLeg = std::find(m_legOk.begin(), m_legOk.end(), 0);
+    if (firstBadLeg != m_legOk.end())
+    {
+        size_t leg = firstBadLeg - m_legOk.begin();
+        out.verdict = leg + 1 == legCount ? ReachVerdict::END_UNREACHABLE : ReachVerdict::FOOD_UNREACHABLE;
+        out.recipeIndex = leg;
+        out.from = m_planets[m_legs[leg]].id;
+        out.to = m_planets[m_legs[leg + 1]].id;
+        return;
+    }
+
+    for (uint32_t i = 0; i < m_planets.size(); i++)
+    {
+        if (m_planets[i].hasFood && !m_reachedFromStart[m_component[i]])
+        {
+            out.verdict = ReachVerdict::FOOD_PLANET_UNREACHABLE;
+            out.to = m_planets[i].id;
+            return;
+        }
+    }
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "levelmodel.h"
+
+#include <cstdint>
+#include <vector>
+
+// Whether the player can get through a level at all, quick enough to rerun on every edit. Like trajectory.h
+// this is a rough model, not the game's physics:
+//
+//  - The player can get from planet A to planet B when their gravity ranges overlap, or when B's range is
+//    within jumpDistance of A's surface. Jumps depend on A's size, so this goes one way only.
+//  - Each food is picked up from the nearest planet whose gravity range it's in
+//  - The level is solvable if the player can go start planet -> each food's planet in recipe order -> end
+//    planet, and every planet marked as having food can be reached from the start
+struct ReachabilityParams
+{
+    float rangeRadiusPerScale; // Gravity range's radius at scale 1
+    float jumpDistance;
+};
+
+enum class ReachVerdict
+{
+    SOLVABLE,
+    NO_START, // Not exactly one start planet
+    NO_END, // Not exactly one end planet
+    FOOD_OFF_PLANET, // A food isn't inside any planet's gravity range
+    FOOD_UNREACHABLE, // Can't get to a food's planet from the previous one in the recipe
+    END_UNREACHABLE, // Can't get to the end planet after the last food
+    FOOD_PLANET_UNREACHABLE, // A planet marked as having food can't be reached from the start
+};
+
+struct ReachabilityReport
+{
+    ReachVerdict verdict = ReachVerdict::SOLVABLE;
+    size_t recipeIndex = 0; // Food the verdict is about, for FOOD_OFF_PLANET and FOOD_UNREACHABLE
+    // The first leg of the route that can't be done. For FOOD_PLANET_UNREACHABLE, just `to` is set.
+    ObjectId from = NO_OBJECT;
+    ObjectId to = NO_OBJECT;
+    std::vector<ObjectId> unreachablePlanets; // Can't be reached from the start by any route
+};
+
+class ReachabilityAnalyzer
+{
+public:
+    // Only reads objects, so it can also run on a snapshot. Reuses out's and its own storage between calls.
+    void analyze(const LevelObjects& objects, const ReachabilityParams& params, ReachabilityReport& out);
+
+private:
+    struct Planet
+    {
+        float x;
+        float y;
+        float range; // Gravity range radius
+        float reach; // How far from its center the player can get to another range from here
+        ObjectId id;
+        bool hasFood;
+    };
+
+    // Scratch space for one search thread, over components rather than planets
+    struct Search
+    {
+        std::vector<uint32_t> visitStamp;
+        std::vector<uint32_t> queue;
+        uint32_t stamp = 0;
+    };
+
+    static constexpr uint32_t NO_PLANET = UINT32_MAX;
+
+    void buildGraph();
+    void findComponents();
+    uint32_t planetAt(ImVec2 pos) const;
+    bool canGo(uint32_t from, uint32_t to, Search& search, std::vector<uint8_t>* reachedOut) const;
+
+    std::vector<Planet> m_planets; // Sorted by x, so neighbours are found by scanning a short stretch
+    float m_maxRange = 0;
+    float m_maxReach = 0;
+
+    // Edges out of planet i are m_edges[m_edgeStart[i]] up to m_edges[m_edgeStart[i + 1]]
+    std::vector<std::pair<uint32_t, uint32_t>> m_edgeList;
+    std::vector<uint32_t> m_edgeStart;
+    std::vector<uint32_t> m_edges;
+
+    // Strongly connected components: planets that can all get to each other. Most levels are one or a few
+    // big ones, so most legs of the route are answered without searching, and the rest only search the
+    // (much smaller) graph between components.
+    std::vector<uint32_t> m_component; // Per planet
+    uint32_t m_componentCount = 0;
+    std::vector<uint32_t> m_componentEdgeStart;
+    std::vector<uint32_t> m_componentEdges;
+
+    // Tarjan's algorithm scratch space
+    std::vector<uint32_t> m_visitIndex;
+    std::vector<uint32_t> m_lowLink;
+    std::vector<uint8_t> m_onStack;
+    std::vector<uint32_t> m_stack;
+    std::vector<std::pair<uint32_t, uint32_t>> m_callStack; // Planet, next edge to follow
+
+    std::vector<uint32_t> m_legs; // Planets to visit in order, start to end
+    std::vector<uint8_t> m_legOk; // Whether m_legs[i + 1] can be reached from m_legs[i]
+    std::vector<size_t> m_openLegs; // Legs that need a search
+    std::vector<uint8_t> m_reachedFromStart; // Per component
+    std::vector<Search> m_searches;
+};
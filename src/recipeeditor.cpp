@@ -1,4 +1,5 @@
 #include "recipeeditor.h"
+#include "alloctracker.h"
 #include "global.h"
 
 #include "imgui.h"
@@ -8,45 +9,44 @@
 
 void showRecipeEditor()
 {
+    ALLOC_SCOPE(AllocTag::RECIPE_EDITOR);
     ImGui::SetNextWindowSize(ImVec2(400, 600), ImGuiCond_FirstUseEver);
     ImGui::Begin("Recipe Editor");
-    if (!g_level || g_level->foods.size() == 0)
+    if (!g_level || g_level->objects.count(ObjectKind::FOOD) == 0)
     {
         ImGui::End();
         return;
     }
 
-    std::vector<std::string> foodNames;
-    std::vector<const char *> foodNameCstrs;
+    LevelObjects& objects = g_level->objects;
+    const std::vector<ObjectId>& recipe = objects.recipeOrder();
 
-    for (auto& food : g_level->foods)
+    // The texture names outlive the frame, so the list can just point at them
+    FrameVector<const char*> foodNameCstrs{ArenaAllocator<const char*>(g_frameArena)};
+    foodNameCstrs.reserve(recipe.size());
+    for (ObjectId food : recipe)
     {
-        std::string basicName = food->tex->shortName;
-        foodNames.push_back(basicName);
-    }
-    for (auto& name : foodNames)
-    {
-        foodNameCstrs.push_back(name.c_str());
+        foodNameCstrs.push_back(objects.texture(objects.rowOf(food))->shortName.c_str());
     }
 
     static int idx = 0;
 
     // Make currently selected food the current list item, if a food is selected
-    auto foodIt = std::find(g_level->foods.begin(), g_level->foods.end(), g_selectedObj);
-    if (foodIt != g_level->foods.end())
+    auto foodIt = std::find(recipe.begin(), recipe.end(), g_selection.primary());
+    if (foodIt != recipe.end())
     {
-        idx = foodIt - g_level->foods.begin();
+        idx = foodIt - recipe.begin();
     }
 
     // Check if index is valid, in case we deleted a food
-    if (idx >= g_level->foods.size()) idx = g_level->foods.size() - 1;
+    if (idx >= recipe.size()) idx = recipe.size() - 1;
 
     int oldIdx = idx;
     ImGui::ListBox("Recipe order", &idx, foodNameCstrs.data(), foodNameCstrs.size(), 10);
     if (idx != oldIdx)
     {
-        g_selectedObj = g_level->foods[idx];
-        g_viz.setWorldPos(g_selectedObj->pos);
+        g_selection.selectOnly(recipe[idx]);
+        g_viz.setWorldPos(objects.pos[objects.rowOf(recipe[idx])]);
     }
 
     int desIdx = idx;
@@ -57,10 +57,13 @@ void showRecipeEditor()
     if (ImGui::Button("Move up")) desIdx = idx - 1;
 
     if (desIdx < 0) desIdx = 0;
-    else if (desIdx >= g_level->foods.size()) desIdx = g_level->foods.size() - 1;
+    else if (desIdx >= recipe.size()) desIdx = recipe.size() - 1;
 
-    std::swap(g_level->foods[idx], g_level->foods[desIdx]);
+    if (desIdx != idx)
+    {
+        objects.swapRecipeSteps(idx, desIdx);
+        g_undo.recordRecipeSwap(idx, desIdx);
+    }
 
     ImGui::End();
 }
-
@@ -0,0 +1,33 @@
+#include "redrawscheduler.h"
+
+void RedrawScheduler::requestFrames(int count)
+{
+    int current = m_framesRequested;
+    while (current < count && !m_framesRequested.compare_exchange_weak(current, count)) {}
+    wake();
+}
+
+void RedrawScheduler::beginJob()
+{
+    m_jobsPending++;
+    wake();
+}
+
+void RedrawScheduler::endJob()
+{
+    m_jobsPending--;
+
+    // One more frame to show whatever the job produced
+    requestFrames(1);
+}
+
+void RedrawScheduler::frameDrawn()
+{
+    int current = m_framesRequested;
+    while (current > 0 && !m_framesRequested.compare_exchange_weak(current, current - 1)) {}
+}
+
+void RedrawScheduler::wake()
+{
+    if (m_wake) m_wake();
+}
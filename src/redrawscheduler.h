@@ -0,0 +1,33 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+
+// Lets the main loop sleep until there's input instead of redrawing at vsync. Anything that changes on screen
+// without input (animations, background jobs like texture loads or saves) has to ask for frames here.
+class RedrawScheduler
+{
+public:
+    // Draw at least this many more frames. ImGui usually needs a couple of frames to settle after input.
+    void requestFrames(int count);
+
+    // Keep drawing continuously while a job is in flight. Safe to call from any thread.
+    void beginJob();
+    void endJob();
+
+    // Whether the next frame has to be drawn without waiting for input
+    bool hasWork() const { return m_framesRequested > 0 || m_jobsPending > 0; }
+
+    // Called by the main loop for every frame it actually draws
+    void frameDrawn();
+
+    // Wakes the main loop up if it's waiting for events, e.g. glfwPostEmptyEvent
+    void setWakeCallback(std::function<void()> wake) { m_wake = std::move(wake); }
+
+private:
+    void wake();
+
+    std::atomic<int> m_framesRequested{0};
+    std::atomic<int> m_jobsPending{0};
+    std::function<void()> m_wake;
+};
@@ -1,8 +1,11 @@
 #include "savejson.h"
+#include "alloctracker.h"
+#include "profiler.h"
 #include "global.h"
 
 #include "json.hpp"
 
+#include <algorithm>
 #include <unordered_map>
 #include <fstream>
 #include <iomanip>
@@ -10,17 +13,19 @@
 using json = nlohmann::json;
 namespace fs = std::filesystem;
 
-void validateLevelForExport()
+void validateLevelForExport(const LevelModel& level)
 {
-    if (!g_level->player) throw std::runtime_error("Level must contain a player");
-    if (!g_level->customer) throw std::runtime_error("Level must contain a customer");
+    const LevelObjects& objects = level.objects;
+    if (!objects.contains(level.player)) throw std::runtime_error("Level must contain a player");
+    if (!objects.contains(level.customer)) throw std::runtime_error("Level must contain a customer");
 
     int startPlanets = 0;
     int endPlanets = 0;
-    for (auto& planet : g_level->planets)
+    for (size_t row = 0; row < objects.size(); row++)
     {
-        if (planet->order == PlanetOrder::START) startPlanets++;
-        if (planet->order == PlanetOrder::END) endPlanets++;
+        if (objects.kind[row] != ObjectKind::PLANET) continue;
+        if (objects.planetOrder[row] == PlanetOrder::START) startPlanets++;
+        if (objects.planetOrder[row] == PlanetOrder::END) endPlanets++;
     }
 
     if (startPlanets != 1) throw std::runtime_error("Level must contain a single starting planet.\nThere are currently: " + std::to_string(startPlanets));
@@ -32,40 +37,40 @@ static json genVecJson(ImVec2 vec)
     return json::array({vec.x, vec.y});
 }
 
-static json genObjectJson(const std::shared_ptr<ObjectModel>& obj)
+static json genObjectJson(const LevelObjects& objects, size_t row)
 {
-    ImVec2 pos(obj->pos);
+    ImVec2 pos(objects.pos[row]);
     pos.y = -pos.y; // Flip Y coordinate (little hacky but w/e)
 
     return {
         {"type", "Animation"},
         {"data", {
-                 {"texture", obj->tex->shortName},
-                 {"cols", obj->cols},
-                 {"span", obj->span},
+                 {"texture", objects.texture(row)->shortName},
+                 {"cols", objects.cols[row]},
+                 {"span", objects.span[row]},
                  {"frame", 0},
-                 {"scale", obj->scale},
+                 {"scale", objects.scale[row]},
                  {"position", genVecJson(pos)},
-                 {"anchor", genVecJson(obj->anchor)},
+                 {"anchor", genVecJson(objects.anchor[row])},
              }
         }
     };
 }
 
-static json genPlanetJson(const std::shared_ptr<PlanetModel>& planet)
+static json genPlanetJson(const LevelObjects& objects, size_t row)
 {
-    json planetJson = genObjectJson(planet);
-    planetJson["data"]["hasFood"] = planet->hasFood;
-    planetJson["data"]["isSun"] = planet->type == PlanetType::SUN;
-    planetJson["data"]["isStorage"] = planet->type == PlanetType::STORAGE;
-    planetJson["data"]["isBlackHole"] = planet->type == PlanetType::BLACKHOLE;
-    planetJson["data"]["isSeasonPlanet"] = planet->type == PlanetType::SEASON;
+    json planetJson = genObjectJson(objects, row);
+    planetJson["data"]["hasFood"] = (objects.flags[row] & OBJECT_HAS_FOOD) != 0;
+    planetJson["data"]["isSun"] = objects.planetType[row] == PlanetType::SUN;
+    planetJson["data"]["isStorage"] = objects.planetType[row] == PlanetType::STORAGE;
+    planetJson["data"]["isBlackHole"] = objects.planetType[row] == PlanetType::BLACKHOLE;
+    planetJson["data"]["isSeasonPlanet"] = objects.planetType[row] == PlanetType::SEASON;
     return planetJson;
 }
 
-static json genPlanetRingJson(const std::shared_ptr<PlanetModel>& planet)
+static json genPlanetRingJson(const LevelObjects& objects, size_t row)
 {
-    json j = genObjectJson(planet);
+    json j = genObjectJson(objects, row);
     j["data"]["texture"] = "range";
     j["data"]["cols"] = 5;
     j["data"]["span"] = 5;
@@ -74,26 +79,23 @@ static json genPlanetRingJson(const std::shared_ptr<PlanetModel>& planet)
     return j;
 }
 
-static std::pair<json, json> genPlanetsJson(const std::shared_ptr<LevelModel>& level)
+static std::pair<json, json> genPlanetsJson(const LevelModel& level)
 {
+    const LevelObjects& objects = level.objects;
+    std::vector<size_t> planetRows = objects.rowsOfKind(ObjectKind::PLANET);
+
     // Find start planet and end planet (there should be at least 1 guaranteed)
-    auto startIt = std::find_if(
-            level->planets.begin(),
-            level->planets.end(),
-            [](std::shared_ptr<PlanetModel> planet) {
-                return planet->order == PlanetOrder::START;
-            });
-    IM_ASSERT(startIt != level->planets.end());
-    std::shared_ptr<PlanetModel> startPlanet = *startIt;
-
-    auto endIt = std::find_if(
-            level->planets.begin(),
-            level->planets.end(),
-            [](std::shared_ptr<PlanetModel> planet) {
-                return planet->order == PlanetOrder::END;
-            });
-    IM_ASSERT(endIt != level->planets.end());
-    std::shared_ptr<PlanetModel> endPlanet = *endIt;
+    auto startIt = std::find_if(planetRows.begin(), planetRows.end(), [&](size_t row) {
+        return objects.planetOrder[row] == PlanetOrder::START;
+    });
+    IM_ASSERT(startIt != planetRows.end());
+    size_t startPlanet = *startIt;
+
+    auto endIt = std::find_if(planetRows.begin(), planetRows.end(), [&](size_t row) {
+        return objects.planetOrder[row] == PlanetOrder::END;
+    });
+    IM_ASSERT(endIt != planetRows.end());
+    size_t endPlanet = *endIt;
 
     // Planets json
 
@@ -101,37 +103,39 @@ static std::pair<json, json> genPlanetsJson(const std::shared_ptr<LevelModel>& l
     planetsJson["type"] = "Node";
     planetRingsJson["type"] = "Node";
 
-    planetsJson["children"]["startPlanet"] = genPlanetJson(startPlanet);
-    planetsJson["children"]["endPlanet"] = genPlanetJson(endPlanet);
-    planetRingsJson["children"]["startPlanetRange"] = genPlanetRingJson(startPlanet);
-    planetRingsJson["children"]["endPlanetRange"] = genPlanetRingJson(endPlanet);
+    planetsJson["children"]["startPlanet"] = genPlanetJson(objects, startPlanet);
+    planetsJson["children"]["endPlanet"] = genPlanetJson(objects, endPlanet);
+    planetRingsJson["children"]["startPlanetRange"] = genPlanetRingJson(objects, startPlanet);
+    planetRingsJson["children"]["endPlanetRange"] = genPlanetRingJson(objects, endPlanet);
 
     int planetIdx = 1;
-    for (auto& planet : level->planets)
+    for (size_t row : planetRows)
     {
-        if (planet->order == PlanetOrder::MIDDLE)
+        if (objects.planetOrder[row] == PlanetOrder::MIDDLE)
         {
             std::string planetName = "planet" + std::to_string(planetIdx);
             std::string planetRangeName = "planet" + std::to_string(planetIdx++) + "Range";
-            planetsJson["children"][planetName] = genPlanetJson(planet);
-            planetRingsJson["children"][planetRangeName] = genPlanetRingJson(planet);
+            planetsJson["children"][planetName] = genPlanetJson(objects, row);
+            planetRingsJson["children"][planetRangeName] = genPlanetRingJson(objects, row);
         }
     }
 
     return {planetsJson, planetRingsJson};
 }
 
-static json genFoodsJson(const std::shared_ptr<LevelModel>& level)
+static json genFoodsJson(const LevelModel& level)
 {
     json foodListJson;
     foodListJson["type"] = "Node";
 
-    for (size_t foodIdx = 0; foodIdx != level->foods.size(); ++foodIdx)
+    const LevelObjects& objects = level.objects;
+    const std::vector<ObjectId>& recipe = objects.recipeOrder();
+    for (size_t foodIdx = 0; foodIdx != recipe.size(); ++foodIdx)
     {
-        auto& food = level->foods[foodIdx];
-        json foodJson = genObjectJson(food);
-        foodJson["data"]["cookable"] = food->cookable;
-        foodJson["data"]["seasonable"] = food->seasonable;
+        size_t row = objects.rowOf(recipe[foodIdx]);
+        json foodJson = genObjectJson(objects, row);
+        foodJson["data"]["cookable"] = (objects.flags[row] & OBJECT_COOKABLE) != 0;
+        foodJson["data"]["seasonable"] = (objects.flags[row] & OBJECT_SEASONABLE) != 0;
 
         std::string foodName = "food" + std::to_string(foodIdx + 1);
         foodListJson["children"][foodName] = foodJson;
@@ -142,6 +146,8 @@ static json genFoodsJson(const std::shared_ptr<LevelModel>& level)
 
 void saveAssetsJson()
 {
+    PROFILE_ZONE("saveAssetsJson");
+    ALLOC_SCOPE(AllocTag::JSON_SAVE);
     fs::path assetsJsonPath = g_assetMan.getAssetPathRoot() / "json" / "assets.json";
     std::ifstream fin(assetsJsonPath);
     json assetsJson;
@@ -157,20 +163,18 @@ void saveAssetsJson()
     fout << std::setw(4) << assetsJson << std::endl;
 }
 
-void saveJsonLevel(const std::string &filename, const std::shared_ptr<LevelModel> &level)
+void saveLevelJson(const std::string& filename, const LevelModel& level)
 {
-    validateLevelForExport();
-
+    PROFILE_ZONE("saveLevelJson");
+    ALLOC_SCOPE(AllocTag::JSON_SAVE);
     // Create initial level json
     json levelJson;
 
-    std::string levelNumStr = "lv" + std::to_string(level->levelNumber);
-
-    saveAssetsJson();
+    std::string levelNumStr = "lv" + std::to_string(level.levelNumber);
 
     // Save level timer
     levelJson["scenes"][levelNumStr]["children"]["game"]["children"]["timer"]["type"] = "Node";
-    levelJson["scenes"][levelNumStr]["children"]["game"]["children"]["timer"]["data"]["timer"] = level->levelTimer;
+    levelJson["scenes"][levelNumStr]["children"]["game"]["children"]["timer"]["data"]["timer"] = level.levelTimer;
 
     // Add planets and foods
     auto planetJsonPair = genPlanetsJson(level);
@@ -181,14 +185,14 @@ void saveJsonLevel(const std::string &filename, const std::shared_ptr<LevelModel
     levelJson["scenes"][levelNumStr]["children"]["game"]["children"]["food"] = genFoodsJson(level);
 
     // Add player and customer
-    levelJson["scenes"][levelNumStr]["children"]["game"]["children"]["customer"] = genObjectJson(level->customer);
-    levelJson["scenes"][levelNumStr]["children"]["game"]["children"]["player"] = genObjectJson(level->player);
+    levelJson["scenes"][levelNumStr]["children"]["game"]["children"]["customer"] = genObjectJson(level.objects, level.objects.rowOf(level.customer));
+    levelJson["scenes"][levelNumStr]["children"]["game"]["children"]["player"] = genObjectJson(level.objects, level.objects.rowOf(level.player));
 
     // Add food and planet counts
     levelJson["scenes"][levelNumStr]["children"]["game"]["children"]["numPlanets"]["type"] = "Node";
-    levelJson["scenes"][levelNumStr]["children"]["game"]["children"]["numPlanets"]["data"]["num"] = level->planets.size() - 2;
+    levelJson["scenes"][levelNumStr]["children"]["game"]["children"]["numPlanets"]["data"]["num"] = level.objects.count(ObjectKind::PLANET) - 2;
     levelJson["scenes"][levelNumStr]["children"]["game"]["children"]["numFood"]["type"] = "Node";
-    levelJson["scenes"][levelNumStr]["children"]["game"]["children"]["numFood"]["data"]["num"] = level->foods.size();
+    levelJson["scenes"][levelNumStr]["children"]["game"]["children"]["numFood"]["data"]["num"] = level.objects.count(ObjectKind::FOOD);
 
     levelJson["scenes"][levelNumStr]["type"] = "Node";
     levelJson["scenes"][levelNumStr]["children"]["game"]["type"] = "Node";
@@ -209,3 +213,11 @@ void saveJsonLevel(const std::string &filename, const std::shared_ptr<LevelModel
     std::ofstream ofile(filename);
     ofile << std::setw(4) << levelJson << std::endl;
 }
+
+void saveJsonLevel(const std::string &filename, const std::shared_ptr<LevelModel> &level)
+{
+    PROFILE_ZONE("saveJsonLevel");
+    validateLevelForExport(*level);
+    saveAssetsJson();
+    saveLevelJson(filename, *level);
+}
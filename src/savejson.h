@@ -3,4 +3,14 @@
 #include "levelmodel.h"
 #include <string>
 
+// Throws if the game couldn't load the level
+void validateLevelForExport(const LevelModel& level);
+
+// Adds every loaded texture to the game's assets.json
+void saveAssetsJson();
+
+// Writes just the level file. Only reads level, so it can run on another thread given a snapshot.
+void saveLevelJson(const std::string& filename, const LevelModel& level);
+
+// All of the above
 void saveJsonLevel(const std::string& filename, const std::shared_ptr<LevelModel>& level);
@@ -0,0 +1,201 @@
+#include "selection.h"
+
+#include <algorithm>
+#include <cfloat>
+
+static constexpr int MIN_SLOT_BITS = 4;
+
+size_t Selection::findSlot(ObjectId id) const
+{
+    // Fibonacci hashing, IDs are handed out in sequence
+    size_t mask = m_slots.size() - 1;
+    size_t slot = static_cast<size_t>((id * 0x9E3779B97F4A7C15ull) >> m_slotShift);
+    while (m_slots[slot] != NO_OBJECT && m_slots[slot] != id) slot = (slot + 1) & mask;
+    return slot;
+}
+
+void Selection::rebuildSlots()
+{
+    size_t slots = size_t(1) << MIN_SLOT_BITS;
+    m_slotShift = 64 - MIN_SLOT_BITS;
+    while (slots < m_ids.size() * 2)
+    {
+        slots *= 2;
+        m_slotShift--;
+    }
+
+    m_slots.assign(slots, NO_OBJECT);
+    for (ObjectId id : m_ids) m_slots[findSlot(id)] = id;
+}
+
+void Selection::clear()
+{
+    // Only touches the slots in use, so clearing a small selection out of a big table stays cheap. The table
+    // was filled in m_ids order, so going backwards never frees a slot that a later ID probed past.
+    if (!m_slots.empty())
+    {
+        for (auto it = m_ids.rbegin(); it != m_ids.rend(); ++it) m_slots[findSlot(*it)] = NO_OBJECT;
+    }
+    m_ids.clear();
+    m_primary = NO_OBJECT;
+}
+
+void Selection::selectOnly(ObjectId id)
+{
+    clear();
+    if (id != NO_OBJECT) add(id);
+}
+
+void Selection::add(ObjectId id)
+{
+    m_primary = id;
+    if (contains(id)) return;
+
+    m_ids.push_back(id);
+    if (m_ids.size() * 2 > m_slots.size()) rebuildSlots();
+    else m_slots[findSlot(id)] = id;
+}
+
+void Selection::toggle(ObjectId id)
+{
+    if (!contains(id))
+    {
+        add(id);
+        return;
+    }
+
+    // Linear probing can't just empty a slot, but deselecting one object at a time is rare enough to rebuild
+    m_ids.erase(std::find(m_ids.begin(), m_ids.end(), id));
+    rebuildSlots();
+    if (m_primary == id) m_primary = m_ids.empty() ? NO_OBJECT : m_ids.back();
+}
+
+void Selection::set(const std::vector<ObjectId>& ids)
+{
+    clear();
+    for (ObjectId id : ids) add(id);
+    m_primary = ids.empty() ? NO_OBJECT : ids.front();
+}
+
+void Selection::removeMissing(const LevelObjects& objects)
+{
+    // Runs every frame, so only rebuild if something actually went
+    auto missing = std::remove_if(m_ids.begin(), m_ids.end(), [&](ObjectId id) { return !objects.contains(id); });
+    if (missing != m_ids.end())
+    {
+        m_ids.erase(missing, m_ids.end());
+        rebuildSlots();
+    }
+    if (!objects.contains(m_primary)) m_primary = m_ids.empty() ? NO_OBJECT : m_ids.back();
+}
+
+bool Selection::contains(ObjectId id) const
+{
+    if (id == NO_OBJECT || m_slots.empty()) return false;
+    return m_slots[findSlot(id)] == id;
+}
+
+void Selection::rows(const LevelObjects& objects, std::vector<size_t>& out) const
+{
+    out.clear();
+    for (ObjectId id : m_ids)
+    {
+        if (objects.contains(id)) out.push_back(objects.rowOf(id));
+    }
+    std::sort(out.begin(), out.end());
+}
+
+// Reused between calls, so dragging a selection around doesn't allocate every frame
+static std::vector<size_t> s_rows;
+static std::vector<ObjectRecord> s_before;
+
+static void recordBefore(const LevelObjects& objects, const std::vector<size_t>& rows)
+{
+    s_before.clear();
+    for (size_t row : rows) s_before.push_back(objects.record(objects.idAt(row)));
+}
+
+static void finishEdit(LevelObjects& objects, SpatialIndex& index, UndoHistory& undo)
+{
+    for (const ObjectRecord& before : s_before)
+    {
+        index.update(before.id);
+        undo.recordChanges(objects, before);
+    }
+}
+
+void moveSelection(LevelObjects& objects, SpatialIndex& index, UndoHistory& undo, const Selection& selection,
+                   ImVec2 delta)
+{
+    selection.rows(objects, s_rows);
+    recordBefore(objects, s_rows);
+    objects.translate(s_rows, delta);
+    finishEdit(objects, index, undo);
+}
+
+void scaleSelection(LevelObjects& objects, SpatialIndex& index, UndoHistory& undo, const Selection& selection,
+                    float factor)
+{
+    selection.rows(objects, s_rows);
+    if (s_rows.empty()) return;
+
+    ImVec2 min(FLT_MAX, FLT_MAX), max(-FLT_MAX, -FLT_MAX);
+    for (size_t row : s_rows)
+    {
+        ImVec2 pos = objects.pos[row];
+        min = ImVec2(std::min(min.x, pos.x), std::min(min.y, pos.y));
+        max = ImVec2(std::max(max.x, pos.x), std::max(max.y, pos.y));
+    }
+
+    recordBefore(objects, s_rows);
+    objects.scaleAbout(s_rows, ImVec2((min.x + max.x) / 2, (min.y + max.y) / 2), factor);
+    finishEdit(objects, index, undo);
+}
+
+void deleteSelection(LevelObjects& objects, SpatialIndex& index, UndoHistory& undo, Selection& selection)
+{
+    // Every food records its recipe step before any of them are gone, and undo puts them back in reverse. So
+    // record them from the end of the recipe backwards, then each one goes back in after the ones before it.
+    const std::vector<ObjectId>& recipe = objects.recipeOrder();
+    for (auto it = recipe.rbegin(); it != recipe.rend(); ++it)
+    {
+        if (selection.contains(*it)) undo.recordRemove(objects, *it);
+    }
+    for (ObjectId id : selection.ids())
+    {
+        if (!objects.contains(id)) continue;
+        if (objects.kind[objects.rowOf(id)] != ObjectKind::FOOD) undo.recordRemove(objects, id);
+        index.remove(id);
+    }
+    objects.remove(selection.ids());
+    selection.clear();
+}
+
+void duplicateSelection(LevelObjects& objects, SpatialIndex& index, UndoHistory& undo, Selection& selection,
+                        ImVec2 offset)
+{
+    std::vector<ObjectId> copies;
+    for (ObjectId id : selection.ids())
+    {
+        if (!objects.contains(id)) continue;
+        ObjectKind kind = objects.kind[objects.rowOf(id)];
+        if (kind == ObjectKind::PLAYER || kind == ObjectKind::CUSTOMER) continue;
+        ObjectId copy = objects.addCopy(id);
+        copies.push_back(copy);
+
+        // Levels only have one start and one end planet
+        if (kind == ObjectKind::PLANET) objects.planetOrder[objects.rowOf(copy)] = PlanetOrder::MIDDLE;
+    }
+
+    // The copies were all appended, so they're the last rows
+    s_rows.clear();
+    for (size_t row = objects.size() - copies.size(); row < objects.size(); row++) s_rows.push_back(row);
+    objects.translate(s_rows, offset);
+
+    for (ObjectId copy : copies)
+    {
+        undo.recordAdd(objects, copy);
+        index.insert(copy);
+    }
+    selection.set(copies);
+}
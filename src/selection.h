@@ -0,0 +1,57 @@
+#pragma once
+
+#include "levelmodel.h"
+#include "spatialindex.h"
+#include "undohistory.h"
+
+#include <vector>
+
+// The objects picked in the editor. The primary one is what the properties editor shows, and is always part of
+// the selection when there is one. contains() is O(1), since it gets asked per object per frame.
+class Selection
+{
+public:
+    void clear();
+    void selectOnly(ObjectId id); // NO_OBJECT clears
+    void add(ObjectId id); // Becomes the primary
+    void toggle(ObjectId id);
+    void set(const std::vector<ObjectId>& ids); // The first one becomes the primary
+
+    // Forgets objects that aren't in the level anymore, e.g. after an undo
+    void removeMissing(const LevelObjects& objects);
+
+    bool contains(ObjectId id) const;
+    bool empty() const { return m_ids.empty(); }
+    size_t size() const { return m_ids.size(); }
+    const std::vector<ObjectId>& ids() const { return m_ids; }
+    ObjectId primary() const { return m_primary; }
+
+    // Ascending, so batch edits walk the columns front to back. Reuses out's storage.
+    void rows(const LevelObjects& objects, std::vector<size_t>& out) const;
+
+private:
+    size_t findSlot(ObjectId id) const; // Where id is, or the free slot it would go in
+    void rebuildSlots();
+
+    std::vector<ObjectId> m_ids; // In selection order
+    ObjectId m_primary = NO_OBJECT;
+
+    // Open addressing hash set of m_ids, with NO_OBJECT for free slots. A flat table rather than an
+    // unordered_set, so selecting keeps reusing the same memory instead of allocating a node per object.
+    // The size is a power of two, at least twice m_ids.size().
+    std::vector<ObjectId> m_slots;
+    int m_slotShift = 64;
+};
+
+// Batch edits to everything selected. Each keeps the spatial index in sync and records into the current undo
+// step, so a whole batch (or a whole drag of one) undoes in one go.
+void moveSelection(LevelObjects& objects, SpatialIndex& index, UndoHistory& undo, const Selection& selection,
+                   ImVec2 delta);
+// Scales each object and spreads them out from the middle of the selection
+void scaleSelection(LevelObjects& objects, SpatialIndex& index, UndoHistory& undo, const Selection& selection,
+                    float factor);
+void deleteSelection(LevelObjects& objects, SpatialIndex& index, UndoHistory& undo, Selection& selection);
+// Copies everything but the player and customer (a level only has one of each) and selects the copies. Copied
+// start and end planets become middle ones, for the same reason.
+void duplicateSelection(LevelObjects& objects, SpatialIndex& index, UndoHistory& undo, Selection& selection,
+                        ImVec2 offset);
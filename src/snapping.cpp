@@ -0,0 +1,139 @@
+#include "snapping.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+static void considerSnap(float delta, float threshold, float& bestDelta, bool& better)
+{
+    better = std::abs(delta) < threshold && std::abs(delta) < std::abs(bestDelta);
+    if (better) bestDelta = delta;
+}
+
+void Snapper::snapAxis(int axis, const Bounds& self, const SnapSettings& settings, AxisSnap& best) const
+{
+    int other = 1 - axis;
+    best.kind = TargetKind::NONE;
+    best.delta = settings.threshold;
+    bool better;
+
+    if (settings.gridSpacing > 0)
+    {
+        float gridLine = std::round(self.center[axis] / settings.gridSpacing) * settings.gridSpacing;
+        considerSnap(gridLine - self.center[axis], settings.threshold, best.delta, better);
+        if (better) best.kind = TargetKind::GRID;
+    }
+
+    if (settings.toObjects)
+    {
+        for (size_t i = 0; i < m_bounds.size(); i++)
+        {
+            const Bounds& bounds = m_bounds[i];
+            // Centers first, so they win ties with edges
+            for (float target : {bounds.center[axis], bounds.min[axis], bounds.max[axis]})
+            {
+                for (float own : {self.center[axis], self.min[axis], self.max[axis]})
+                {
+                    considerSnap(target - own, settings.threshold, best.delta, better);
+                    if (!better) continue;
+                    best.kind = TargetKind::ALIGN;
+                    best.value = target;
+                    best.neighbour = i;
+                }
+            }
+        }
+    }
+
+    if (settings.toSpacing)
+    {
+        // The closest neighbours before and after, out of the ones level with this object on the other axis
+        float before = -FLT_MAX, after = FLT_MAX;
+        for (const Bounds& bounds : m_bounds)
+        {
+            if (bounds.max[other] < self.min[other] || bounds.min[other] > self.max[other]) continue;
+            if (bounds.max[axis] <= self.center[axis]) before = std::max(before, bounds.max[axis]);
+            if (bounds.min[axis] >= self.center[axis]) after = std::min(after, bounds.min[axis]);
+        }
+
+        float halfSize = (self.max[axis] - self.min[axis]) / 2;
+        if (before != -FLT_MAX && after != FLT_MAX && after - before > 2 * halfSize)
+        {
+            float centered = (before + after) / 2;
+            considerSnap(centered - self.center[axis], settings.threshold, best.delta, better);
+            if (better)
+            {
+                best.kind = TargetKind::SPACING;
+                best.gapStart = before;
+                best.gapEnd = after;
+            }
+        }
+    }
+
+    if (best.kind == TargetKind::NONE) best.delta = 0;
+}
+
+void Snapper::addGuides(int axis, const AxisSnap& snap, const Bounds& self)
+{
+    int other = 1 - axis;
+    ImVec2 start, end;
+    if (snap.kind == TargetKind::ALIGN)
+    {
+        // Along the line both objects now share, spanning the two of them
+        const Bounds& neighbour = m_bounds[snap.neighbour];
+        start[axis] = end[axis] = snap.value;
+        start[other] = std::min(self.min[other], neighbour.min[other]);
+        end[other] = std::max(self.max[other], neighbour.max[other]);
+        m_guides.push_back(SnapGuide{start, end, SnapGuideKind::ALIGN});
+    } else if (snap.kind == TargetKind::SPACING)
+    {
+        // The two equal gaps
+        start[other] = end[other] = self.center[other];
+        start[axis] = snap.gapStart;
+        end[axis] = self.min[axis];
+        m_guides.push_back(SnapGuide{start, end, SnapGuideKind::SPACING});
+        start[axis] = self.max[axis];
+        end[axis] = snap.gapEnd;
+        m_guides.push_back(SnapGuide{start, end, SnapGuideKind::SPACING});
+    }
+}
+
+ImVec2 Snapper::snap(const LevelObjects& objects, const SpatialIndex& index, ObjectId moving, ImVec2 pos,
+                     const SnapSettings& settings, const Selection* draggedAlong)
+{
+    m_guides.clear();
+    if (!objects.contains(moving)) return pos;
+
+    size_t row = objects.rowOf(moving);
+    ImVec2 halfSize(objects.frameSize(row).x * objects.scale[row] / 2, objects.frameSize(row).y * objects.scale[row] / 2);
+    Bounds self{ImVec2(pos.x - halfSize.x, pos.y - halfSize.y), pos, ImVec2(pos.x + halfSize.x, pos.y + halfSize.y)};
+
+    m_bounds.clear();
+    if (settings.toObjects || settings.toSpacing)
+    {
+        ImVec2 searchMin(self.min.x - settings.searchRadius, self.min.y - settings.searchRadius);
+        ImVec2 searchMax(self.max.x + settings.searchRadius, self.max.y + settings.searchRadius);
+        index.queryRect(searchMin, searchMax, ImVec2(0, 0), m_neighbourIds);
+        for (ObjectId id : m_neighbourIds)
+        {
+            if (id == moving) continue;
+            if (draggedAlong && draggedAlong->contains(id)) continue;
+            size_t neighbourRow = objects.rowOf(id);
+            ImVec2 center = objects.pos[neighbourRow];
+            ImVec2 size(objects.frameSize(neighbourRow).x * objects.scale[neighbourRow],
+                        objects.frameSize(neighbourRow).y * objects.scale[neighbourRow]);
+            m_bounds.push_back(Bounds{ImVec2(center.x - size.x / 2, center.y - size.y / 2), center,
+                                      ImVec2(center.x + size.x / 2, center.y + size.y / 2)});
+        }
+    }
+
+    AxisSnap snaps[2];
+    for (int axis = 0; axis < 2; axis++) snapAxis(axis, self, settings, snaps[axis]);
+
+    ImVec2 offset(snaps[0].delta, snaps[1].delta);
+    self.min = ImVec2(self.min.x + offset.x, self.min.y + offset.y);
+    self.center = ImVec2(self.center.x + offset.x, self.center.y + offset.y);
+    self.max = ImVec2(self.max.x + offset.x, self.max.y + offset.y);
+    for (int axis = 0; axis < 2; axis++) addGuides(axis, snaps[axis], self);
+
+    return self.center;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "levelmodel.h"
+#include "selection.h"
+#include "spatialindex.h"
+
+#include "imgui.h"
+
+#include <vector>
+
+// World units unless noted
+struct SnapSettings
+{
+    float threshold; // Snaps happen within this distance
+    float searchRadius; // How far around the dragged object to look for objects to line up with
+    float gridSpacing; // 0 to not snap to the grid
+    bool toObjects; // Centers and edges
+    bool toSpacing; // Equal gaps between the neighbours on either side
+};
+
+enum class SnapGuideKind { ALIGN, SPACING };
+
+// A world space line to draw, showing what the dragged object snapped to
+struct SnapGuide
+{
+    ImVec2 start;
+    ImVec2 end;
+    SnapGuideKind kind;
+};
+
+// Snapping for dragged objects. The objects to line up with come from the spatial index, so the cost depends
+// on how crowded it is around the object rather than on the size of the level. Each axis snaps separately,
+// to whichever target is closest.
+class Snapper
+{
+public:
+    // Where to put `moving`, whose center the drag would otherwise put at pos. Objects in draggedAlong move with
+    // it, so they aren't snapped to.
+    ImVec2 snap(const LevelObjects& objects, const SpatialIndex& index, ObjectId moving, ImVec2 pos,
+                const SnapSettings& settings, const Selection* draggedAlong = nullptr);
+
+    // From the last snap(), until clearGuides()
+    const std::vector<SnapGuide>& guides() const { return m_guides; }
+    void clearGuides() { m_guides.clear(); }
+
+private:
+    struct Bounds
+    {
+        ImVec2 min;
+        ImVec2 center;
+        ImVec2 max;
+    };
+
+    enum class TargetKind { NONE, GRID, ALIGN, SPACING };
+
+    // The best snap found so far on one axis
+    struct AxisSnap
+    {
+        TargetKind kind;
+        float delta;
+        float value; // ALIGN: the coordinate lined up with
+        size_t neighbour; // ALIGN: index into m_bounds
+        float gapStart; // SPACING: the neighbours' near edges
+        float gapEnd;
+    };
+
+    void snapAxis(int axis, const Bounds& self, const SnapSettings& settings, AxisSnap& best) const;
+    void addGuides(int axis, const AxisSnap& snap, const Bounds& self);
+
+    std::vector<ObjectId> m_neighbourIds;
+    std::vector<Bounds> m_bounds; // Of the neighbours
+    std::vector<SnapGuide> m_guides;
+};
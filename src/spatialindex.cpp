@@ -0,0 +1,278 @@
+#include "spatialindex.h"
+
+#include <algorithm>
+#include <cmath>
+
+static void getObjectBounds(const LevelObjects& objects, size_t row, ImVec2& min, ImVec2& max)
+{
+    float scaledWidth = objects.frameSize(row).x * objects.scale[row];
+    float scaledHeight = objects.frameSize(row).y * objects.scale[row];
+
+    min = ImVec2(objects.pos[row].x - scaledWidth / 2, objects.pos[row].y - scaledHeight / 2);
+    max = ImVec2(objects.pos[row].x + scaledWidth / 2, objects.pos[row].y + scaledHeight / 2);
+}
+
+uint32_t SpatialIndex::findEntry(ObjectId obj) const
+{
+    auto it = m_entryById.find(obj);
+    return it != m_entryById.end() ? it->second : NO_ENTRY;
+}
+
+uint64_t SpatialIndex::cellKey(int cx, int cy)
+{
+    return (static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32) | static_cast<uint32_t>(cy);
+}
+
+int SpatialIndex::cellCoord(float worldCoord) const
+{
+    // Clamped, since casting a float that doesn't fit in an int is undefined. NaN ends up at the low end.
+    constexpr float MAX_CELL = 1 << 24;
+    float cell = std::floor(worldCoord / m_cellSize);
+    if (!(cell > -MAX_CELL)) return -static_cast<int>(MAX_CELL);
+    if (!(cell < MAX_CELL)) return static_cast<int>(MAX_CELL);
+    return static_cast<int>(cell);
+}
+
+void SpatialIndex::rebuild(const std::shared_ptr<LevelModel>& level)
+{
+    m_level = level.get();
+    m_revision++;
+    m_nextSequence = 0;
+    m_maxScale = 0;
+    m_entries.clear();
+    m_entryById.clear();
+    m_cells.clear();
+    m_oversized.clear();
+
+    if (!level) return;
+
+    for (size_t row = 0; row < level->objects.size(); row++)
+    {
+        insert(level->objects.idAt(row));
+    }
+}
+
+void SpatialIndex::insert(ObjectId obj)
+{
+    if (!m_level || !m_level->objects.contains(obj) || findEntry(obj) != NO_ENTRY) return;
+    m_revision++;
+
+    const LevelObjects& objects = m_level->objects;
+    size_t row = objects.rowOf(obj);
+
+    // The kind is the high bits of the priority, and ObjectKind is already in hit test order
+    Entry entry;
+    entry.obj = obj;
+    getObjectBounds(objects, row, entry.min, entry.max);
+    entry.scale = objects.scale[row];
+    entry.priority = (static_cast<uint64_t>(objects.kind[row]) << 56) | m_nextSequence++;
+    entry.queryStamp = 0;
+    entry.oversized = false;
+    m_maxScale = std::max(m_maxScale, entry.scale);
+
+    auto entryIdx = static_cast<uint32_t>(m_entries.size());
+    m_entries.push_back(entry);
+    m_entryById[obj] = entryIdx;
+    addToCells(entryIdx);
+}
+
+void SpatialIndex::remove(ObjectId obj)
+{
+    uint32_t entryIdx = findEntry(obj);
+    if (entryIdx == NO_ENTRY) return;
+    m_revision++;
+
+    auto lastIdx = static_cast<uint32_t>(m_entries.size() - 1);
+
+    removeFromCells(entryIdx);
+    m_entryById.erase(obj);
+
+    // Swap and pop, then fix up the cells that referred to the moved entry
+    if (entryIdx != lastIdx)
+    {
+        removeFromCells(lastIdx);
+        m_entries[entryIdx] = m_entries[lastIdx];
+        m_entryById[m_entries[entryIdx].obj] = entryIdx;
+        m_entries.pop_back();
+        addToCells(entryIdx);
+    }
+    else
+    {
+        m_entries.pop_back();
+    }
+}
+
+void SpatialIndex::update(ObjectId obj)
+{
+    uint32_t entryIdx = findEntry(obj);
+    if (entryIdx == NO_ENTRY)
+    {
+        insert(obj);
+        return;
+    }
+
+    m_revision++;
+    const LevelObjects& objects = m_level->objects;
+    size_t row = objects.rowOf(obj);
+
+    Entry& entry = m_entries[entryIdx];
+    ImVec2 newMin, newMax;
+    getObjectBounds(objects, row, newMin, newMax);
+    entry.scale = objects.scale[row];
+    m_maxScale = std::max(m_maxScale, entry.scale);
+
+    // Most drags stay within the same cells, in which case only the bounds need refreshing
+    bool sameCells = cellCoord(newMin.x) == cellCoord(entry.min.x) && cellCoord(newMin.y) == cellCoord(entry.min.y) &&
+                     cellCoord(newMax.x) == cellCoord(entry.max.x) && cellCoord(newMax.y) == cellCoord(entry.max.y);
+    if (sameCells)
+    {
+        entry.min = newMin;
+        entry.max = newMax;
+        return;
+    }
+
+    removeFromCells(entryIdx);
+    entry.min = newMin;
+    entry.max = newMax;
+    addToCells(entryIdx);
+}
+
+ObjectId SpatialIndex::findAt(ImVec2 worldPos) const
+{
+    const Entry* best = nullptr;
+    auto consider = [&](uint32_t entryIdx) {
+        const Entry& entry = m_entries[entryIdx];
+        if (worldPos.x >= entry.min.x && worldPos.y >= entry.min.y &&
+            worldPos.x <= entry.max.x && worldPos.y <= entry.max.y &&
+            (!best || entry.priority < best->priority))
+        {
+            best = &entry;
+        }
+    };
+
+    auto cellIt = m_cells.find(cellKey(cellCoord(worldPos.x), cellCoord(worldPos.y)));
+    if (cellIt != m_cells.end())
+    {
+        for (uint32_t entryIdx : cellIt->second) consider(entryIdx);
+    }
+    for (uint32_t entryIdx : m_oversized) consider(entryIdx);
+
+    return best ? best->obj : NO_OBJECT;
+}
+
+void SpatialIndex::queryRect(ImVec2 min, ImVec2 max, ImVec2 marginPerScale, std::vector<ObjectId>& out) const
+{
+    out.clear();
+    m_queryScratch.clear();
+
+    auto overlaps = [&](const Entry& entry) {
+        float marginX = marginPerScale.x * entry.scale;
+        float marginY = marginPerScale.y * entry.scale;
+        return entry.max.x + marginX >= min.x && entry.min.x - marginX <= max.x &&
+               entry.max.y + marginY >= min.y && entry.min.y - marginY <= max.y;
+    };
+
+    int cx0 = cellCoord(min.x - marginPerScale.x * m_maxScale);
+    int cy0 = cellCoord(min.y - marginPerScale.y * m_maxScale);
+    int cx1 = cellCoord(max.x + marginPerScale.x * m_maxScale);
+    int cy1 = cellCoord(max.y + marginPerScale.y * m_maxScale);
+    auto numCells = static_cast<uint64_t>(cx1 - cx0 + 1) * static_cast<uint64_t>(cy1 - cy0 + 1);
+
+    if (numCells >= m_entries.size())
+    {
+        // Zoomed far out, walking the cells would cost more than just testing every object
+        for (uint32_t entryIdx = 0; entryIdx < m_entries.size(); entryIdx++)
+        {
+            if (overlaps(m_entries[entryIdx])) m_queryScratch.push_back(entryIdx);
+        }
+    }
+    else
+    {
+        m_queryStamp++;
+        for (int cx = cx0; cx <= cx1; cx++)
+        {
+            for (int cy = cy0; cy <= cy1; cy++)
+            {
+                auto cellIt = m_cells.find(cellKey(cx, cy));
+                if (cellIt == m_cells.end()) continue;
+
+                for (uint32_t entryIdx : cellIt->second)
+                {
+                    const Entry& entry = m_entries[entryIdx];
+                    if (entry.queryStamp == m_queryStamp) continue;
+                    entry.queryStamp = m_queryStamp;
+
+                    if (overlaps(entry)) m_queryScratch.push_back(entryIdx);
+                }
+            }
+        }
+
+        // Not in any cell, so no dedup needed
+        for (uint32_t entryIdx : m_oversized)
+        {
+            if (overlaps(m_entries[entryIdx])) m_queryScratch.push_back(entryIdx);
+        }
+    }
+
+    std::sort(m_queryScratch.begin(), m_queryScratch.end(), [&](uint32_t a, uint32_t b) {
+        return m_entries[a].priority < m_entries[b].priority;
+    });
+    for (uint32_t entryIdx : m_queryScratch)
+    {
+        out.push_back(m_entries[entryIdx].obj);
+    }
+}
+
+void SpatialIndex::addToCells(uint32_t entryIdx)
+{
+    Entry& entry = m_entries[entryIdx];
+    auto numCells = static_cast<uint64_t>(cellCoord(entry.max.x) - cellCoord(entry.min.x) + 1) *
+                    static_cast<uint64_t>(cellCoord(entry.max.y) - cellCoord(entry.min.y) + 1);
+    entry.oversized = numCells > MAX_CELLS_PER_ENTRY;
+    if (entry.oversized)
+    {
+        m_oversized.push_back(entryIdx);
+        return;
+    }
+
+    for (int cx = cellCoord(entry.min.x); cx <= cellCoord(entry.max.x); cx++)
+    {
+        for (int cy = cellCoord(entry.min.y); cy <= cellCoord(entry.max.y); cy++)
+        {
+            m_cells[cellKey(cx, cy)].push_back(entryIdx);
+        }
+    }
+}
+
+void SpatialIndex::removeFromCells(uint32_t entryIdx)
+{
+    const Entry& entry = m_entries[entryIdx];
+    if (entry.oversized)
+    {
+        auto it = std::find(m_oversized.begin(), m_oversized.end(), entryIdx);
+        if (it != m_oversized.end())
+        {
+            *it = m_oversized.back();
+            m_oversized.pop_back();
+        }
+        return;
+    }
+
+    for (int cx = cellCoord(entry.min.x); cx <= cellCoord(entry.max.x); cx++)
+    {
+        for (int cy = cellCoord(entry.min.y); cy <= cellCoord(entry.max.y); cy++)
+        {
+            auto cellIt = m_cells.find(cellKey(cx, cy));
+            if (cellIt == m_cells.end()) continue;
+
+            auto& cell = cellIt->second;
+            auto it = std::find(cell.begin(), cell.end(), entryIdx);
+            if (it != cell.end())
+            {
+                *it = cell.back();
+                cell.pop_back();
+            }
+            // Empty cells are kept around, so dragging back and forth doesn't keep reallocating them
+        }
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "levelmodel.h"
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// Uniform grid over the sprite AABBs of every level object, so hit tests only look at the objects near the
+// query point instead of scanning the whole level. Has to be told whenever an object moves, resizes, or is
+// added or removed.
+class SpatialIndex
+{
+public:
+    explicit SpatialIndex(float cellSize = 256.f): m_cellSize{cellSize} {}
+
+    void rebuild(const std::shared_ptr<LevelModel>& level);
+    bool isBuiltFor(const std::shared_ptr<LevelModel>& level) const { return m_level == level.get(); }
+
+    void insert(ObjectId obj);
+    void remove(ObjectId obj);
+    void update(ObjectId obj);
+
+    // Object whose sprite contains worldPos, or NO_OBJECT. Overlaps resolve in ObjectKind order:
+    // planets, then foods, then the customer and player.
+    ObjectId findAt(ImVec2 worldPos) const;
+
+    // Fills out with every object whose AABB overlaps the world rect [min, max], in the same order as findAt()
+    // prefers them. Decorations drawn around objects (like gravity ranges) grow with the object's scale, so
+    // each AABB is first grown by marginPerScale * scale. out is reused, so steady-state queries don't allocate.
+    void queryRect(ImVec2 min, ImVec2 max, ImVec2 marginPerScale, std::vector<ObjectId>& out) const;
+
+    size_t size() const { return m_entries.size(); }
+
+    // Bumped on every change, so things derived from level geometry can tell when they're stale
+    uint64_t revision() const { return m_revision; }
+
+private:
+    struct Entry
+    {
+        ObjectId obj;
+        ImVec2 min;
+        ImVec2 max;
+        float scale;
+        uint64_t priority; // Lower wins when objects overlap
+        mutable uint32_t queryStamp; // Dedups objects spanning several cells within one queryRect()
+        bool oversized; // In m_oversized instead of the cells
+    };
+
+    static constexpr uint32_t NO_ENTRY = UINT32_MAX;
+    // Anything spanning more cells than this (say, after typing in a huge scale) skips the grid, and every
+    // query just tests it directly
+    static constexpr uint64_t MAX_CELLS_PER_ENTRY = 64;
+
+    uint32_t findEntry(ObjectId obj) const;
+    static uint64_t cellKey(int cx, int cy);
+    int cellCoord(float worldCoord) const;
+
+    void addToCells(uint32_t entryIdx);
+    void removeFromCells(uint32_t entryIdx);
+
+    float m_cellSize;
+    const LevelModel* m_level = nullptr;
+    uint64_t m_nextSequence = 0;
+    uint64_t m_revision = 0;
+    float m_maxScale = 0; // Only ever grows until the next rebuild, it just bounds how far queries look
+
+    std::vector<Entry> m_entries;
+    std::unordered_map<ObjectId, uint32_t> m_entryById;
+    std::unordered_map<uint64_t, std::vector<uint32_t>> m_cells;
+    std::vector<uint32_t> m_oversized;
+
+    mutable uint32_t m_queryStamp = 0;
+    mutable std::vector<uint32_t> m_queryScratch;
+};
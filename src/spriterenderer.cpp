@@ -0,0 +1,62 @@
+#include "spriterenderer.h"
+
+#include <algorithm>
+
+void SpriteRenderer::findSpriteRuns(const std::vector<SpriteInstance>& sprites, std::vector<SpriteRun>& runs)
+{
+    runs.clear();
+    for (size_t i = 0; i < sprites.size(); i++)
+    {
+        if (runs.empty() || runs.back().tex != sprites[i].tex)
+        {
+            runs.push_back(SpriteRun{i, 0, sprites[i].tex});
+        }
+        runs.back().count++;
+    }
+}
+
+void ImGuiSpriteRenderer::setSprites(const std::vector<SpriteInstance>& sprites)
+{
+    // Plain assignment sizes m_sprites exactly, so every slightly bigger view would reallocate
+    if (m_sprites.capacity() < sprites.size()) m_sprites.reserve(std::max(sprites.size(), m_sprites.capacity() * 2));
+    m_sprites.assign(sprites.begin(), sprites.end());
+    findSpriteRuns(sprites, m_runs);
+}
+
+void ImGuiSpriteRenderer::draw(ImDrawList* drawList, const VisualizationModel& viz)
+{
+    ImVec2 worldViewStart = viz.screenToWorldSpace(viz.getCanvas().start);
+    ImVec2 worldViewEnd = viz.screenToWorldSpace(viz.getCanvas().end);
+
+    // screen = world * zoom + origin, same as VisualizationModel::worldToScreenSpace()
+    float zoom = viz.getZoom();
+    ImVec2 origin = viz.worldToScreenSpace(ImVec2(0, 0));
+
+    for (auto& run : m_runs)
+    {
+        drawList->PushTextureID(run.tex);
+        drawList->PrimReserve(static_cast<int>(run.count) * 6, static_cast<int>(run.count) * 4);
+
+        int unused = 0;
+        for (size_t i = run.first; i != run.first + run.count; i++)
+        {
+            const SpriteInstance& sprite = m_sprites[i];
+            ImVec2 worldStart(sprite.center.x - sprite.halfSize.x, sprite.center.y - sprite.halfSize.y);
+            ImVec2 worldEnd(sprite.center.x + sprite.halfSize.x, sprite.center.y + sprite.halfSize.y);
+
+            if (worldEnd.x < worldViewStart.x || worldStart.x > worldViewEnd.x ||
+                worldEnd.y < worldViewStart.y || worldStart.y > worldViewEnd.y)
+            {
+                unused++;
+                continue;
+            }
+
+            drawList->PrimRectUV(ImVec2(worldStart.x * zoom + origin.x, worldStart.y * zoom + origin.y),
+                                 ImVec2(worldEnd.x * zoom + origin.x, worldEnd.y * zoom + origin.y),
+                                 sprite.uv0, sprite.uv1, IM_COL32_WHITE);
+        }
+
+        drawList->PrimUnreserve(unused * 6, unused * 4);
+        drawList->PopTextureID();
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "imgui.h"
+#include "vizmodel.h"
+
+#include <vector>
+
+// One textured quad on the level canvas, in world space. The first four fields double as GL instance data.
+struct SpriteInstance
+{
+    ImVec2 center;
+    ImVec2 halfSize;
+    ImVec2 uv0;
+    ImVec2 uv1;
+    ImTextureID tex;
+};
+
+// Retained sprite drawing: the sprite list only gets handed over when it changes, and every frame in between
+// just draws it again under the current camera.
+class SpriteRenderer
+{
+public:
+    virtual ~SpriteRenderer() = default;
+
+    // Consecutive sprites sharing a texture get batched, so callers should group sprites by texture wherever
+    // draw order doesn't matter
+    virtual void setSprites(const std::vector<SpriteInstance>& sprites) = 0;
+
+    // Draws the current sprites in order, at this point in drawList's command stream
+    virtual void draw(ImDrawList* drawList, const VisualizationModel& viz) = 0;
+
+protected:
+    struct SpriteRun
+    {
+        size_t first;
+        size_t count;
+        ImTextureID tex;
+    };
+
+    // Reuses runs' storage, so re-sending a similar sprite list doesn't allocate
+    static void findSpriteRuns(const std::vector<SpriteInstance>& sprites, std::vector<SpriteRun>& runs);
+};
+
+// Writes the sprites' quads straight into the draw list, which works anywhere ImGui does (including headless).
+// Sprites outside the canvas are skipped each frame.
+class ImGuiSpriteRenderer : public SpriteRenderer
+{
+public:
+    void setSprites(const std::vector<SpriteInstance>& sprites) override;
+    void draw(ImDrawList* drawList, const VisualizationModel& viz) override;
+
+private:
+    std::vector<SpriteInstance> m_sprites;
+    std::vector<SpriteRun> m_runs;
+};
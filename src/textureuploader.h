@@ -0,0 +1,23 @@
+#pragma once
+
+// Hands decoded RGBA8 pixels to whatever backend will display them, so AssetMan itself doesn't need GL
+class TextureUploader
+{
+public:
+    virtual ~TextureUploader() = default;
+
+    // Returns the backend texture handle that ends up in Texture::id
+    virtual void* upload(const unsigned char* rgbaPixels, int width, int height) = 0;
+
+    // Overwrites rows [firstRow, firstRow + rows) of a texture from upload(), for images that keep changing.
+    // rgbaRows starts at firstRow and has to be as wide as the texture.
+    virtual void update(void* id, const unsigned char* rgbaRows, int width, int firstRow, int rows) = 0;
+};
+
+// For CLI tools and benchmarks that run without a GPU; textures keep their size and name but get no handle
+class NullTextureUploader : public TextureUploader
+{
+public:
+    void* upload(const unsigned char*, int, int) override { return nullptr; }
+    void update(void*, const unsigned char*, int, int, int) override {}
+};
@@ -0,0 +1,102 @@
+#include "trajectory.h"
+
+float planetPullStrength(const LevelObjects& objects, size_t row, float gravity)
+{
+    float weight = 1;
+    if (objects.planetType[row] == PlanetType::SUN) weight = 2;
+    else if (objects.planetType[row] == PlanetType::BLACKHOLE) weight = 4;
+
+    float scale = objects.scale[row];
+    return gravity * weight * scale * scale;
+}
+
+void TrajectorySimulator::setPlanets(const LevelObjects& objects, float rangeRadiusPerScale, float gravity)
+{
+    m_x.clear();
+    m_y.clear();
+    m_rangeSq.clear();
+    m_surfaceSq.clear();
+    m_strength.clear();
+
+    for (size_t row = 0; row < objects.size(); row++)
+    {
+        if (objects.kind[row] != ObjectKind::PLANET) continue;
+
+        float scale = objects.scale[row];
+        float rangeRadius = rangeRadiusPerScale * scale;
+        float surfaceRadius = objects.frameSize(row).x * scale / 2;
+
+        m_x.push_back(objects.pos[row].x);
+        m_y.push_back(objects.pos[row].y);
+        m_rangeSq.push_back(rangeRadius * rangeRadius);
+        m_surfaceSq.push_back(surfaceRadius * surfaceRadius);
+        m_strength.push_back(planetPullStrength(objects, row, gravity));
+    }
+
+    // Padding: out of range of everything and never hit
+    while (m_x.size() % LANES != 0)
+    {
+        m_x.push_back(0);
+        m_y.push_back(0);
+        m_rangeSq.push_back(0);
+        m_surfaceSq.push_back(-1);
+        m_strength.push_back(0);
+    }
+}
+
+void TrajectorySimulator::simulate(ImVec2 start, ImVec2 velocity, float timestep, int maxSteps, Trajectory& out) const
+{
+    out.points.clear();
+    out.points.push_back(start);
+    out.end = TrajectoryEnd::TIMED_OUT;
+
+    float x = start.x, y = start.y;
+    float vx = velocity.x, vy = velocity.y;
+    size_t count = m_x.size();
+
+    // The player usually starts out sitting on a planet, so only count hits once it's been clear of them all
+    bool launched = false;
+
+    for (int step = 0; step < maxSteps; step++)
+    {
+        // Per-lane sums, only added up at the end, so the lanes don't depend on each other
+        float accelX[LANES] = {}, accelY[LANES] = {}, hit[LANES] = {};
+        for (size_t i = 0; i < count; i += LANES)
+        {
+            for (size_t lane = 0; lane < LANES; lane++)
+            {
+                float dx = m_x[i + lane] - x;
+                float dy = m_y[i + lane] - y;
+                float distSq = dx * dx + dy * dy + 1e-3f;
+
+                // Selects between constants rather than branches, so this stays vectorizable
+                float inRange = distSq < m_rangeSq[i + lane] ? 1.f : 0.f;
+                float pull = inRange * m_strength[i + lane] / distSq;
+                accelX[lane] += dx * pull;
+                accelY[lane] += dy * pull;
+                hit[lane] += distSq < m_surfaceSq[i + lane] ? 1.f : 0.f;
+            }
+        }
+
+        float ax = 0, ay = 0, anyHit = 0;
+        for (size_t lane = 0; lane < LANES; lane++)
+        {
+            ax += accelX[lane];
+            ay += accelY[lane];
+            anyHit += hit[lane];
+        }
+
+        if (anyHit == 0) launched = true;
+        else if (launched)
+        {
+            out.end = TrajectoryEnd::HIT_PLANET;
+            return;
+        }
+
+        vx += ax * timestep;
+        vy += ay * timestep;
+        x += vx * timestep;
+        y += vy * timestep;
+        out.points.push_back(ImVec2(x, y));
+    }
+}
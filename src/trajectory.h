@@ -0,0 +1,51 @@
+#pragma once
+
+#include "levelmodel.h"
+
+#include "imgui.h"
+
+#include <vector>
+
+// Rough preview of how the player flies through the planets' gravity, so levels can be tuned without a build.
+// This isn't the game's physics, just close enough to see where a launch goes:
+//
+//  - A planet only pulls while the player is inside its gravity range
+//  - The pull is toward the planet's center, proportional to scale squared (times a per-type weight, see
+//    planetPullStrength()) and falling off as 1/distance, which is what gravity does in 2D
+//  - The path ends when it touches a planet's sprite, apart from the one it launched from
+//
+// Integrated with semi-implicit Euler at a fixed timestep.
+
+// Acceleration toward the planet at distance 1, so divide by distance. Suns pull twice as hard as a normal
+// planet of the same size and black holes four times.
+float planetPullStrength(const LevelObjects& objects, size_t row, float gravity);
+
+enum class TrajectoryEnd { TIMED_OUT, HIT_PLANET };
+
+struct Trajectory
+{
+    std::vector<ImVec2> points; // World space, one per step starting at the launch point
+    TrajectoryEnd end;
+};
+
+class TrajectorySimulator
+{
+public:
+    // Copies out what the simulation needs from every planet, so call again whenever the planets change.
+    // rangeRadiusPerScale is the gravity range's radius at scale 1.
+    void setPlanets(const LevelObjects& objects, float rangeRadiusPerScale, float gravity);
+
+    // Reuses out's storage
+    void simulate(ImVec2 start, ImVec2 velocity, float timestep, int maxSteps, Trajectory& out) const;
+
+private:
+    // Planets are processed this many at a time with no branches, which the compiler turns into SIMD.
+    // The arrays are padded to a multiple of it with planets that can't affect anything.
+    static constexpr size_t LANES = 8;
+
+    std::vector<float> m_x;
+    std::vector<float> m_y;
+    std::vector<float> m_rangeSq;
+    std::vector<float> m_surfaceSq;
+    std::vector<float> m_strength;
+};
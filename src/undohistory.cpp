@@ -0,0 +1,246 @@
+#include "undohistory.h"
+
+#include <algorithm>
+#include <cstring>
+
+static constexpr ObjectField ALL_FIELDS[] = {
+    ObjectField::POS, ObjectField::ANCHOR, ObjectField::SCALE, ObjectField::COLS,
+    ObjectField::SPAN, ObjectField::FLAGS, ObjectField::PLANET_TYPE, ObjectField::PLANET_ORDER,
+};
+
+template <typename T>
+static uint64_t pack(const T& value)
+{
+    static_assert(sizeof(T) <= sizeof(uint64_t), "Field too big to pack");
+    uint64_t packed = 0;
+    std::memcpy(&packed, &value, sizeof(T));
+    return packed;
+}
+
+template <typename T>
+static void unpack(uint64_t packed, T& value)
+{
+    std::memcpy(&value, &packed, sizeof(T));
+}
+
+// ImVec2 is trivially copyable, but its user-provided constructor makes it non-trivial, so memcpy into one trips
+// -Wclass-memaccess. Going through a plain float array keeps that build clean.
+static void unpack(uint64_t packed, ImVec2& value)
+{
+    float xy[2];
+    std::memcpy(xy, &packed, sizeof(xy));
+    value = ImVec2(xy[0], xy[1]);
+}
+
+static uint64_t packField(const ObjectRecord& rec, ObjectField field)
+{
+    switch (field)
+    {
+    case ObjectField::POS: return pack(rec.pos);
+    case ObjectField::ANCHOR: return pack(rec.anchor);
+    case ObjectField::SCALE: return pack(rec.scale);
+    case ObjectField::COLS: return pack(rec.cols);
+    case ObjectField::SPAN: return pack(rec.span);
+    case ObjectField::FLAGS: return pack(rec.flags);
+    case ObjectField::PLANET_TYPE: return pack(rec.planetType);
+    case ObjectField::PLANET_ORDER: return pack(rec.planetOrder);
+    }
+    return 0;
+}
+
+static void writeField(LevelObjects& objects, size_t row, ObjectField field, uint64_t packed)
+{
+    switch (field)
+    {
+    case ObjectField::POS: unpack(packed, objects.pos[row]); break;
+    case ObjectField::ANCHOR: unpack(packed, objects.anchor[row]); break;
+    case ObjectField::SCALE: unpack(packed, objects.scale[row]); break;
+    case ObjectField::COLS: unpack(packed, objects.cols[row]); break;
+    case ObjectField::SPAN: unpack(packed, objects.span[row]); break;
+    case ObjectField::FLAGS: unpack(packed, objects.flags[row]); break;
+    case ObjectField::PLANET_TYPE: unpack(packed, objects.planetType[row]); break;
+    case ObjectField::PLANET_ORDER: unpack(packed, objects.planetOrder[row]); break;
+    }
+}
+
+static uint64_t fieldKey(ObjectId id, ObjectField field)
+{
+    return (id << 3) | static_cast<uint64_t>(field);
+}
+
+void UndoHistory::setMaxSteps(size_t maxSteps)
+{
+    m_maxSteps = std::max<size_t>(maxSteps, 1);
+    while (m_steps.size() > m_maxSteps)
+    {
+        m_deltaCount -= m_steps.front().deltas.size();
+        m_steps.pop_front();
+        if (m_applied > 0) m_applied--;
+    }
+}
+
+void UndoHistory::clear()
+{
+    m_steps.clear();
+    m_applied = 0;
+    m_stepOpen = false;
+    m_deltaCount = 0;
+    m_openFieldDeltas.clear();
+}
+
+UndoHistory::Step& UndoHistory::openStep()
+{
+    if (m_stepOpen) return m_steps.back();
+
+    // Doing something new throws away whatever could have been redone
+    while (m_steps.size() > m_applied)
+    {
+        m_deltaCount -= m_steps.back().deltas.size();
+        m_steps.pop_back();
+    }
+
+    m_steps.emplace_back();
+    m_stepsStarted++;
+    m_applied++;
+    m_stepOpen = true;
+    m_openFieldDeltas.clear();
+
+    if (m_steps.size() > m_maxSteps)
+    {
+        m_deltaCount -= m_steps.front().deltas.size();
+        m_steps.pop_front();
+        m_applied--;
+    }
+
+    return m_steps.back();
+}
+
+void UndoHistory::pushDelta(const Delta& delta)
+{
+    openStep().deltas.push_back(delta);
+    m_deltaCount++;
+    m_changes++;
+}
+
+void UndoHistory::recordChanges(const LevelObjects& objects, const ObjectRecord& before)
+{
+    if (!objects.contains(before.id)) return;
+    ObjectRecord after = objects.record(before.id);
+
+    for (ObjectField field : ALL_FIELDS)
+    {
+        uint64_t beforeValue = packField(before, field);
+        uint64_t afterValue = packField(after, field);
+        if (beforeValue == afterValue) continue;
+
+        Step& step = openStep();
+        auto it = m_openFieldDeltas.find(fieldKey(before.id, field));
+        if (it != m_openFieldDeltas.end())
+        {
+            step.deltas[it->second].after = afterValue;
+            m_changes++;
+            continue;
+        }
+
+        m_openFieldDeltas[fieldKey(before.id, field)] = static_cast<uint32_t>(step.deltas.size());
+        pushDelta(Delta{DeltaType::FIELD, field, 0, before.id, beforeValue, afterValue});
+    }
+}
+
+void UndoHistory::recordAdd(const LevelObjects& objects, ObjectId id)
+{
+    if (!objects.contains(id)) return;
+
+    Step& step = openStep();
+    auto recordIdx = static_cast<uint32_t>(step.records.size());
+    step.records.push_back(objects.record(id));
+    pushDelta(Delta{DeltaType::ADD, ObjectField::POS, recordIdx, id, 0, 0});
+}
+
+void UndoHistory::recordRemove(const LevelObjects& objects, ObjectId id)
+{
+    if (!objects.contains(id)) return;
+
+    Step& step = openStep();
+    auto recordIdx = static_cast<uint32_t>(step.records.size());
+    step.records.push_back(objects.record(id));
+    pushDelta(Delta{DeltaType::REMOVE, ObjectField::POS, recordIdx, id, 0, 0});
+
+    // Later changes to the same ID can't be folded into deltas from before it was removed
+    for (ObjectField field : ALL_FIELDS) m_openFieldDeltas.erase(fieldKey(id, field));
+}
+
+void UndoHistory::recordRecipeSwap(size_t a, size_t b)
+{
+    if (a == b) return;
+    pushDelta(Delta{DeltaType::RECIPE_SWAP, ObjectField::POS, 0, NO_OBJECT, a, b});
+}
+
+void UndoHistory::endStep()
+{
+    m_stepOpen = false;
+    m_openFieldDeltas.clear();
+}
+
+void UndoHistory::applyDelta(const Step& step, const Delta& delta, bool forward, LevelModel& level, SpatialIndex& index)
+{
+    LevelObjects& objects = level.objects;
+
+    switch (delta.type)
+    {
+    case DeltaType::FIELD:
+        if (!objects.contains(delta.id)) return;
+        writeField(objects, objects.rowOf(delta.id), delta.field, forward ? delta.after : delta.before);
+        index.update(delta.id);
+        break;
+    case DeltaType::ADD:
+    case DeltaType::REMOVE:
+        if ((delta.type == DeltaType::ADD) == forward)
+        {
+            if (objects.contains(delta.id)) return;
+            const ObjectRecord& rec = step.records[delta.recordIdx];
+            objects.restore(rec);
+            index.insert(rec.id);
+            if (rec.kind == ObjectKind::PLAYER) level.player = rec.id;
+            else if (rec.kind == ObjectKind::CUSTOMER) level.customer = rec.id;
+        }
+        else
+        {
+            index.remove(delta.id);
+            objects.remove(delta.id);
+        }
+        break;
+    case DeltaType::RECIPE_SWAP:
+        if (std::max(delta.before, delta.after) >= objects.recipeOrder().size()) return;
+        objects.swapRecipeSteps(delta.before, delta.after);
+        break;
+    }
+}
+
+bool UndoHistory::undo(LevelModel& level, SpatialIndex& index)
+{
+    endStep();
+    if (!canUndo()) return false;
+
+    const Step& step = m_steps[--m_applied];
+    for (auto it = step.deltas.rbegin(); it != step.deltas.rend(); ++it)
+    {
+        applyDelta(step, *it, false, level, index);
+    }
+    m_changes++;
+    return true;
+}
+
+bool UndoHistory::redo(LevelModel& level, SpatialIndex& index)
+{
+    endStep();
+    if (!canRedo()) return false;
+
+    const Step& step = m_steps[m_applied++];
+    for (const Delta& delta : step.deltas)
+    {
+        applyDelta(step, delta, true, level, index);
+    }
+    m_changes++;
+    return true;
+}
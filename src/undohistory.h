@@ -0,0 +1,86 @@
+#pragma once
+
+#include "levelmodel.h"
+#include "spatialindex.h"
+
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+// The per-object fields undo tracks
+enum class ObjectField : uint8_t { POS, ANCHOR, SCALE, COLS, SPAN, FLAGS, PLANET_TYPE, PLANET_ORDER };
+
+// Undo/redo as a list of steps, each made of small deltas (one field of one object, an object added or
+// removed, two recipe steps swapped) rather than copies of the level. Undoing or redoing a step only touches
+// what that step changed.
+//
+// Everything recorded goes into the current step until endStep(). Changing the same field of the same object
+// again within a step just updates that delta, so a whole drag ends up as one delta.
+class UndoHistory
+{
+public:
+    explicit UndoHistory(size_t maxSteps = 200): m_maxSteps{maxSteps} {}
+
+    // Oldest steps are dropped past this
+    void setMaxSteps(size_t maxSteps);
+    size_t maxSteps() const { return m_maxSteps; }
+
+    void clear();
+
+    // Compares the object against how it was in before, and records every field that changed
+    void recordChanges(const LevelObjects& objects, const ObjectRecord& before);
+    void recordAdd(const LevelObjects& objects, ObjectId id); // Call after setting up the new object
+    void recordRemove(const LevelObjects& objects, ObjectId id); // Call before removing it
+    void recordRecipeSwap(size_t a, size_t b);
+    void endStep();
+
+    bool canUndo() const { return m_applied > 0; }
+    bool canRedo() const { return m_applied < m_steps.size(); }
+
+    // Also keeps index and the level's player/customer in sync. Return false if there was nothing to do.
+    bool undo(LevelModel& level, SpatialIndex& index);
+    bool redo(LevelModel& level, SpatialIndex& index);
+
+    size_t stepCount() const { return m_steps.size(); }
+    size_t deltaCount() const { return m_deltaCount; }
+    uint64_t stepsStarted() const { return m_stepsStarted; } // Only ever goes up
+
+    // Bumped whenever a change is recorded, undone or redone. Unlike SpatialIndex::revision(), this also
+    // covers changes that don't move anything, like properties and the recipe order.
+    uint64_t changes() const { return m_changes; }
+
+private:
+    enum class DeltaType : uint8_t { FIELD, ADD, REMOVE, RECIPE_SWAP };
+
+    struct Delta
+    {
+        DeltaType type;
+        ObjectField field; // FIELD only
+        uint32_t recordIdx; // ADD and REMOVE, into Step::records
+        ObjectId id;
+        uint64_t before; // FIELD: the packed value, RECIPE_SWAP: one recipe step
+        uint64_t after; // FIELD: the packed value, RECIPE_SWAP: the other recipe step
+    };
+
+    struct Step
+    {
+        std::vector<Delta> deltas;
+        std::vector<ObjectRecord> records;
+    };
+
+    Step& openStep();
+    void pushDelta(const Delta& delta);
+    void applyDelta(const Step& step, const Delta& delta, bool forward, LevelModel& level, SpatialIndex& index);
+
+    size_t m_maxSteps;
+    std::deque<Step> m_steps;
+    size_t m_applied = 0; // Steps before this are done, the rest can be redone
+    bool m_stepOpen = false;
+    size_t m_deltaCount = 0;
+    uint64_t m_stepsStarted = 0;
+    uint64_t m_changes = 0;
+
+    // FIELD deltas in the open step, keyed by (id << 3) | field, for coalescing
+    std::unordered_map<uint64_t, uint32_t> m_openFieldDeltas;
+};
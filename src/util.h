@@ -1,5 +0,0 @@
-#pragma once
-
-#include "levelmodel.h"
-
-std::vector<std::shared_ptr<ObjectModel>> getAllLevelObjects(const std::shared_ptr<LevelModel>& level);
@@ -1,113 +1,351 @@
 #include "visualizer.h"
+#include "alloctracker.h"
+#include "framestats.h"
+#include "profiler.h"
 #include "levelmodel.h"
+#include "trajectory.h"
+#include "gravityfield.h"
+#include "reachability.h"
+#include "overlapdetector.h"
+#include "snapping.h"
+#include "gridrenderer.h"
 
 #include "imgui.h"
-#include "util.h"
 #include "global.h"
 
+#include <algorithm>
+#include <chrono>
 #include <memory>
+#include <vector>
 #include <cmath>
+#include <cfloat>
+#include <cstdio>
 
 constexpr float MIN_ZOOM = 0.1;
 constexpr float MAX_ZOOM = 1.5;
 
-static void showLevelObject(ImDrawList *drawList, const std::shared_ptr<ObjectModel>& object)
+// All gravity ranges seem to have this hard-coded scale at the moment...
+constexpr float GRAV_RANGE_SCALE = 3.f;
+
+static VisualizerStats s_stats;
+
+// What each cached sprite is, so the stats can be counted against the canvas every frame rather than against
+// the whole cached region. Kept apart from s_sprites, which gets reordered by texture.
+enum class SpriteStatKind { OBJECT, OBJECT_LOD, RANGE, RANGE_LOD };
+struct SpriteStat
 {
-    if (!object) return;
+    ImVec2 worldStart;
+    ImVec2 worldEnd;
+    SpriteStatKind kind;
+};
+static std::vector<SpriteStat> s_spriteStats; // Reused every rebuild
 
-    float scaledWidth = object->frameSize().x * object->scale;
-    float scaledHeight = object->frameSize().y * object->scale;
+static bool s_showStatsOverlay = false;
 
-    ImVec2 worldTexStart(object->pos.x - scaledWidth / 2,
-                         object->pos.y - scaledHeight / 2);
-    ImVec2 worldTexEnd(object->pos.x + scaledWidth / 2,
-                       object->pos.y + scaledHeight / 2);
+// Objects smaller than this on screen are drawn from their thumbnail, and their gravity ranges as outlines
+static float s_lodThresholdPx = 24.f;
 
-    ImVec2 screenStart = g_viz.worldToScreenSpace(worldTexStart);
-    ImVec2 screenEnd = g_viz.worldToScreenSpace(worldTexEnd);
+static std::unique_ptr<SpriteRenderer> s_spriteRenderer = std::make_unique<ImGuiSpriteRenderer>();
+static std::vector<SpriteInstance> s_sprites; // Reused every rebuild
+static std::unique_ptr<GridRenderer> s_gridRenderer = std::make_unique<ImGuiGridRenderer>();
 
-    ImVec2 uv0(0, 0);
-    ImVec2 uv1(object->uvEnd());
+// The sprites handed to s_spriteRenderer cover this much of the world, and stay valid until something
+// they were built from changes or the view wanders out of it
+struct CanvasCache
+{
+    bool valid = false;
+    uint64_t levelRevision;
+    uint64_t textureRevision;
+    float zoom;
+    bool showGravRanges;
+    float lodThresholdPx;
+    ImVec2 worldStart;
+    ImVec2 worldEnd;
+};
+
+static bool s_canvasCacheEnabled = true;
+static CanvasCache s_canvasCache;
+
+// Flight path from the player for a launch angle and speed, rerun whenever the level or the settings change
+struct TrajectoryPreview
+{
+    bool enabled = false;
+    float angleDeg = -60; // Clockwise from +x, since y points down
+    float speed = 400; // World units per second
+    float seconds = 10;
 
-    drawList->AddImage(object->tex->id, screenStart, screenEnd, uv0, uv1);
+    bool valid = false;
+    uint64_t levelRevision;
+    uint64_t levelChanges; // Planet types change the pull without moving anything in the index
+    TrajectorySimulator sim;
+    Trajectory path;
+};
 
-    // Show gravity range if it's a planet
-    auto planet = std::dynamic_pointer_cast<PlanetModel>(object);
-    if (planet && g_showGravRanges)
-    {
-        // All gravity ranges seem to have this hard-coded scale at the moment...
-        constexpr float GRAV_RANGE_SCALE = 3.f;
+static TrajectoryPreview s_trajectory;
 
-        float scaledGravWidth = g_gravRangeTex->width * object->scale / 5 * GRAV_RANGE_SCALE;
-        float scaledGravHeight = g_gravRangeTex->height * object->scale * GRAV_RANGE_SCALE;
+// Gravity constant for both the trajectory and the field overlay, see planetPullStrength()
+static float s_gravity = 400000;
 
-        ImVec2 worldRangeStart(object->pos.x - scaledGravWidth / 2, object->pos.y - scaledGravHeight / 2);
-        ImVec2 worldRangeEnd(object->pos.x + scaledGravWidth / 2, object->pos.y + scaledGravHeight / 2);
+static bool s_showGravityField = false;
+static std::unique_ptr<GravityFieldMap> s_fieldMap; // Only allocated once shown
+static std::shared_ptr<Texture> s_fieldTex;
 
-        ImVec2 screenRangeStart = g_viz.worldToScreenSpace(worldRangeStart);
-        ImVec2 screenRangeEnd = g_viz.worldToScreenSpace(worldRangeEnd);
+// Whether the level can be beaten at all, rerun whenever the level or the settings change
+struct ReachabilityCheck
+{
+    bool enabled = false;
+    float jumpDistance = 300; // World units past a planet's surface
 
-        ImVec2 uv0(0.2, 0);
-        ImVec2 uv1(0.4, 1);
+    bool valid = false;
+    uint64_t levelRevision;
+    uint64_t levelChanges;
+    double ms;
+    ReachabilityAnalyzer analyzer;
+    ReachabilityReport report;
+};
 
-        drawList->AddImage(g_gravRangeTex->id, screenRangeStart, screenRangeEnd, uv0, uv1);
-    }
+static ReachabilityCheck s_reach;
+
+static bool s_showOverlaps = true;
+static OverlapDetector s_overlaps;
+
+// Snapping while dragging objects, unless Alt is held
+static bool s_snapEnabled = true;
+static Snapper s_snapper;
+
+static bool rectsOverlap(ImVec2 aStart, ImVec2 aEnd, ImVec2 bStart, ImVec2 bEnd)
+{
+    return aEnd.x >= bStart.x && aStart.x <= bEnd.x && aEnd.y >= bStart.y && aStart.y <= bEnd.y;
+}
+
+// Same size the gravity range sprites get drawn at
+static float gravRangeRadiusPerScale()
+{
+    return g_gravRangeTex->width / 5.f * GRAV_RANGE_SCALE / 2;
+}
+
+// Half the size of a scale 1 gravity range, which is also how far past its sprite an object can draw
+static ImVec2 gravRangeMarginPerScale()
+{
+    if (!g_showGravRanges) return ImVec2(0, 0);
+    return ImVec2(g_gravRangeTex->width / 5.f * GRAV_RANGE_SCALE / 2, g_gravRangeTex->height * GRAV_RANGE_SCALE / 2);
+}
+
+static void addSprite(ImTextureID tex, ImVec2 worldStart, ImVec2 worldEnd, ImVec2 uv0, ImVec2 uv1)
+{
+    ImVec2 center((worldStart.x + worldEnd.x) / 2, (worldStart.y + worldEnd.y) / 2);
+    ImVec2 halfSize((worldEnd.x - worldStart.x) / 2, (worldEnd.y - worldStart.y) / 2);
+    s_sprites.push_back(SpriteInstance{center, halfSize, uv0, uv1, tex});
+}
+
+static bool isBelowLodThreshold(const LevelObjects& objects, size_t row)
+{
+    ImVec2 frameSize = objects.frameSize(row);
+    float screenSize = std::max(frameSize.x, frameSize.y) * objects.scale[row] * g_viz.getZoom();
+    return screenSize < s_lodThresholdPx;
+}
+
+static void getObjectWorldRect(const LevelObjects& objects, size_t row, ImVec2& worldStart, ImVec2& worldEnd)
+{
+    float scaledWidth = objects.frameSize(row).x * objects.scale[row];
+    float scaledHeight = objects.frameSize(row).y * objects.scale[row];
+
+    worldStart = ImVec2(objects.pos[row].x - scaledWidth / 2, objects.pos[row].y - scaledHeight / 2);
+    worldEnd = ImVec2(objects.pos[row].x + scaledWidth / 2, objects.pos[row].y + scaledHeight / 2);
 }
 
-static void showLevelGrid(ImDrawList *drawList) {
-    ImVec2 worldStart = g_viz.screenToWorldSpace(g_viz.getCanvas().start);
-    ImVec2 worldEnd = g_viz.screenToWorldSpace(g_viz.getCanvas().end);
+static void addLevelObjectSprite(const LevelObjects& objects, size_t row, ImVec2 worldViewStart, ImVec2 worldViewEnd)
+{
+    ImVec2 worldTexStart, worldTexEnd;
+    getObjectWorldRect(objects, row, worldTexStart, worldTexEnd);
+
+    // The object might only be here because its gravity range is visible
+    if (!rectsOverlap(worldTexStart, worldTexEnd, worldViewStart, worldViewEnd)) return;
 
-    constexpr float gridSpacing = 100.f;
+    // Still decoding, it shows up once it lands (see AssetMan::loadTextureAsync())
+    const Texture& tex = *objects.texture(row);
+    if (!tex.ready) return;
 
-    worldStart.x = static_cast<int>(worldStart.x / gridSpacing) * gridSpacing;
-    worldStart.y = static_cast<int>(worldStart.y / gridSpacing) * gridSpacing;
+    // Thumbnails keep the full texture's layout, so the same UVs work for both
+    bool lod = isBelowLodThreshold(objects, row);
+    addSprite(lod ? tex.thumbnailId : tex.id, worldTexStart, worldTexEnd, ImVec2(0, 0), objects.uvEnd(row));
+    s_spriteStats.push_back(SpriteStat{worldTexStart, worldTexEnd, lod ? SpriteStatKind::OBJECT_LOD : SpriteStatKind::OBJECT});
+}
+
+static void addGravRangeSprite(const LevelObjects& objects, size_t planetRow, ImVec2 worldViewStart, ImVec2 worldViewEnd)
+{
+    float scaledGravWidth = g_gravRangeTex->width * objects.scale[planetRow] / 5 * GRAV_RANGE_SCALE;
+    float scaledGravHeight = g_gravRangeTex->height * objects.scale[planetRow] * GRAV_RANGE_SCALE;
 
-    ImU32 color = IM_COL32(50, 50, 50, 255);
+    ImVec2 planetPos = objects.pos[planetRow];
+    ImVec2 worldRangeStart(planetPos.x - scaledGravWidth / 2, planetPos.y - scaledGravHeight / 2);
+    ImVec2 worldRangeEnd(planetPos.x + scaledGravWidth / 2, planetPos.y + scaledGravHeight / 2);
+    if (!rectsOverlap(worldRangeStart, worldRangeEnd, worldViewStart, worldViewEnd)) return;
 
-    for (float x = worldStart.x; x < worldEnd.x; x += gridSpacing)
+    // Far out, the filled ranges mostly just cover up the planets, and they're all overlapping anyway
+    if (g_gravRangeOutlineTex && isBelowLodThreshold(objects, planetRow))
     {
-        ImVec2 p1 = g_viz.worldToScreenSpace(ImVec2(x, 0));
-        p1.y = g_viz.getCanvas().start.y;
+        addSprite(g_gravRangeOutlineTex->id, worldRangeStart, worldRangeEnd, ImVec2(0, 0), ImVec2(1, 1));
+        s_spriteStats.push_back(SpriteStat{worldRangeStart, worldRangeEnd, SpriteStatKind::RANGE_LOD});
+    }
+    else
+    {
+        addSprite(g_gravRangeTex->id, worldRangeStart, worldRangeEnd, ImVec2(0.2, 0), ImVec2(0.4, 1));
+        s_spriteStats.push_back(SpriteStat{worldRangeStart, worldRangeEnd, SpriteStatKind::RANGE});
+    }
+}
 
-        ImVec2 p2 = g_viz.worldToScreenSpace(ImVec2(x, 0));
-        p2.y = g_viz.getCanvas().end.y;
+// Stable, so sprites sharing a texture keep their draw order. std::stable_sort would allocate its own buffer
+// every time, so this merge sorts through frame arena memory instead.
+static void sortSpritesByTexture(size_t first)
+{
+    size_t count = s_sprites.size() - first;
+    auto byTex = [](const SpriteInstance& a, const SpriteInstance& b) { return a.tex < b.tex; };
 
-        drawList->AddLine(p1, p2, color);
+    SpriteInstance* src = s_sprites.data() + first;
+    auto dst = static_cast<SpriteInstance*>(g_frameArena.allocate(count * sizeof(SpriteInstance), alignof(SpriteInstance)));
+    for (size_t width = 1; width < count; width *= 2)
+    {
+        for (size_t lo = 0; lo < count; lo += 2 * width)
+        {
+            size_t mid = std::min(lo + width, count);
+            size_t hi = std::min(lo + 2 * width, count);
+            std::merge(src + lo, src + mid, src + mid, src + hi, dst + lo, byTex);
+        }
+        std::swap(src, dst);
     }
 
-    for (float y = worldStart.y; y < worldEnd.y; y += gridSpacing)
+    if (src != s_sprites.data() + first) std::copy(src, src + count, s_sprites.data() + first);
+}
+
+static bool canvasCacheCovers(ImVec2 worldViewStart, ImVec2 worldViewEnd)
+{
+    const CanvasCache& cache = s_canvasCache;
+    return s_canvasCacheEnabled && cache.valid &&
+           cache.levelRevision == g_levelIndex.revision() &&
+           cache.textureRevision == g_assetMan.revision() &&
+           cache.zoom == g_viz.getZoom() &&
+           cache.showGravRanges == g_showGravRanges &&
+           cache.lodThresholdPx == s_lodThresholdPx &&
+           worldViewStart.x >= cache.worldStart.x && worldViewStart.y >= cache.worldStart.y &&
+           worldViewEnd.x <= cache.worldEnd.x && worldViewEnd.y <= cache.worldEnd.y;
+}
+
+static void rebuildLevelSprites(ImVec2 worldViewStart, ImVec2 worldViewEnd)
+{
+    // Build a view's worth of margin on every side, so panning around doesn't rebuild every frame
+    if (s_canvasCacheEnabled)
     {
-        ImVec2 p1 = g_viz.worldToScreenSpace(ImVec2(0, y));
-        p1.x = g_viz.getCanvas().start.x;
+        ImVec2 viewSize(worldViewEnd.x - worldViewStart.x, worldViewEnd.y - worldViewStart.y);
+        worldViewStart = ImVec2(worldViewStart.x - viewSize.x, worldViewStart.y - viewSize.y);
+        worldViewEnd = ImVec2(worldViewEnd.x + viewSize.x, worldViewEnd.y + viewSize.y);
+    }
+
+    static std::vector<ObjectId> visibleIds;
+    static std::vector<size_t> visibleObjects;
+    g_levelIndex.queryRect(worldViewStart, worldViewEnd, gravRangeMarginPerScale(), visibleIds);
+
+    const LevelObjects& objects = g_level->objects;
+    visibleObjects.clear();
+    for (ObjectId id : visibleIds) visibleObjects.push_back(objects.rowOf(id));
+
+    // The index returns planets, then foods, then the customer and player
+    auto isPlanet = [&](size_t row) { return objects.kind[row] == ObjectKind::PLANET; };
+    auto isFood = [&](size_t row) { return objects.kind[row] == ObjectKind::FOOD; };
+    auto planetsEnd = std::partition_point(visibleObjects.begin(), visibleObjects.end(), isPlanet);
+    auto foodsEnd = std::partition_point(planetsEnd, visibleObjects.end(), isFood);
 
-        ImVec2 p2 = g_viz.worldToScreenSpace(ImVec2(0, y));
-        p2.x = g_viz.getCanvas().end.x;
+    s_sprites.clear();
+    s_spriteStats.clear();
 
-        drawList->AddLine(p1, p2, color);
+    // Gravity ranges are their own layer under everything, like the game's planetRanges node, so they all end
+    // up in one batch (or two, with outlines)
+    if (g_showGravRanges)
+    {
+        for (auto it = visibleObjects.begin(); it != planetsEnd; ++it) addGravRangeSprite(objects, *it, worldViewStart, worldViewEnd);
+        sortSpritesByTexture(0);
     }
+
+    // Planets hardly ever overlap each other and neither do foods, so grouping each by texture
+    // saves draw calls without visibly changing anything
+    size_t planetSpritesStart = s_sprites.size();
+    for (auto it = visibleObjects.begin(); it != planetsEnd; ++it) addLevelObjectSprite(objects, *it, worldViewStart, worldViewEnd);
+    sortSpritesByTexture(planetSpritesStart);
+
+    size_t foodSpritesStart = s_sprites.size();
+    for (auto it = planetsEnd; it != foodsEnd; ++it) addLevelObjectSprite(objects, *it, worldViewStart, worldViewEnd);
+    sortSpritesByTexture(foodSpritesStart);
+
+    for (auto it = foodsEnd; it != visibleObjects.end(); ++it) addLevelObjectSprite(objects, *it, worldViewStart, worldViewEnd);
+
+    s_spriteRenderer->setSprites(s_sprites);
+
+    s_canvasCache.valid = true;
+    s_canvasCache.levelRevision = g_levelIndex.revision();
+    s_canvasCache.textureRevision = g_assetMan.revision();
+    s_canvasCache.zoom = g_viz.getZoom();
+    s_canvasCache.showGravRanges = g_showGravRanges;
+    s_canvasCache.lodThresholdPx = s_lodThresholdPx;
+    s_canvasCache.worldStart = worldViewStart;
+    s_canvasCache.worldEnd = worldViewEnd;
 }
 
-static std::shared_ptr<ObjectModel> findObjectAtScreenPos(ImVec2 pos)
+// The cache usually covers more than the canvas, so this counts what's actually on it
+static void countVisibleSprites(ImVec2 worldViewStart, ImVec2 worldViewEnd)
 {
-    ImVec2 worldPos = g_viz.screenToWorldSpace(pos);
+    s_stats = VisualizerStats{};
+    for (const SpriteStat& sprite : s_spriteStats)
+    {
+        if (!rectsOverlap(sprite.worldStart, sprite.worldEnd, worldViewStart, worldViewEnd)) continue;
+        bool isObject = sprite.kind == SpriteStatKind::OBJECT || sprite.kind == SpriteStatKind::OBJECT_LOD;
+        if (isObject) s_stats.objectsDrawn++;
+        else s_stats.rangesDrawn++;
+        if (sprite.kind == SpriteStatKind::OBJECT_LOD) s_stats.objectsLod++;
+        if (sprite.kind == SpriteStatKind::RANGE_LOD) s_stats.rangesLod++;
+    }
 
-    auto allObjects = getAllLevelObjects(g_level);
+    s_stats.objectsCulled = static_cast<int>(g_levelIndex.size()) - s_stats.objectsDrawn;
+    if (g_showGravRanges) s_stats.rangesCulled = static_cast<int>(g_level->objects.count(ObjectKind::PLANET)) - s_stats.rangesDrawn;
+}
 
-    for (auto obj : allObjects) {
-        float scaledWidth = obj->frameSize().x * obj->scale;
-        float scaledHeight = obj->frameSize().y * obj->scale;
+static void showLevelObjects(ImDrawList *drawList)
+{
+    // Only objects that could touch the canvas get any sprites at all
+    ImVec2 worldViewStart = g_viz.screenToWorldSpace(g_viz.getCanvas().start);
+    ImVec2 worldViewEnd = g_viz.screenToWorldSpace(g_viz.getCanvas().end);
 
-        if (worldPos.x >= (obj->pos.x - scaledWidth / 2) &&
-            worldPos.y >= (obj->pos.y - scaledHeight / 2) &&
-            worldPos.x <= (obj->pos.x + scaledWidth / 2) &&
-            worldPos.y <= (obj->pos.y + scaledHeight / 2))
-        {
-            return obj;
-        }
-    }
+    if (!canvasCacheCovers(worldViewStart, worldViewEnd)) rebuildLevelSprites(worldViewStart, worldViewEnd);
+    countVisibleSprites(worldViewStart, worldViewEnd);
 
-    return nullptr;
+    // Sprites are in world space, panning just changes the transform they're drawn with
+    s_spriteRenderer->draw(drawList, g_viz);
+}
+
+void setSpriteRenderer(std::unique_ptr<SpriteRenderer> renderer)
+{
+    s_spriteRenderer = std::move(renderer);
+    s_canvasCache.valid = false;
+}
+
+void setGridRenderer(std::unique_ptr<GridRenderer> renderer)
+{
+    s_gridRenderer = std::move(renderer);
+}
+
+void setCanvasCacheEnabled(bool enabled)
+{
+    s_canvasCacheEnabled = enabled;
+    s_canvasCache.valid = false;
+}
+
+const VisualizerStats& getVisualizerStats()
+{
+    return s_stats;
+}
+
+static ObjectId findObjectAtScreenPos(ImVec2 pos)
+{
+    return g_levelIndex.findAt(g_viz.screenToWorldSpace(pos));
 }
 
 static void handleScrollWheel()
@@ -125,11 +363,30 @@ static void handleScrollWheel()
     }
 }
 
+// Pixel distances, so snapping feels the same at any zoom
+static SnapSettings currentSnapSettings()
+{
+    constexpr float THRESHOLD_PX = 8;
+    constexpr float SEARCH_RADIUS_PX = 300;
+
+    // The finest grid lines that are showing
+    float alphas[GRID_LEVELS];
+    getGridLevelAlphas(g_viz.getZoom(), alphas);
+    float gridSpacing = 0;
+    for (int level = 0; level < GRID_LEVELS && gridSpacing == 0; level++)
+    {
+        if (alphas[level] > 0) gridSpacing = GRID_SPACINGS[level];
+    }
+
+    return SnapSettings{THRESHOLD_PX / g_viz.getZoom(), SEARCH_RADIUS_PX / g_viz.getZoom(), gridSpacing, true, true};
+}
+
 static void handleDraggingObject()
 {
     // TODO dedup with handleDraggingSpace()?
 
     static bool isDraggingObj = false;
+    static ObjectId grabbedObj; // Snaps, and the rest of the selection keeps its place relative to it
     static ImVec2 mouseDownPos;
     static ImVec2 oldWorldPos;
 
@@ -138,19 +395,81 @@ static void handleDraggingObject()
     if (ImGui::IsItemHovered() && ImGui::IsMouseClicked(0) && !isDraggingObj)
     {
         auto hoverObj = findObjectAtScreenPos(currMousePos);
-        if (hoverObj)
+        if (g_level->objects.contains(hoverObj) && ImGui::GetIO().KeyShift)
         {
+            g_selection.toggle(hoverObj);
+        } else if (g_level->objects.contains(hoverObj))
+        {
+            // Grabbing part of the selection drags all of it
+            if (!g_selection.contains(hoverObj)) g_selection.selectOnly(hoverObj);
             isDraggingObj = true;
-            g_selectedObj = hoverObj;
+            grabbedObj = hoverObj;
             mouseDownPos = currMousePos;
-            oldWorldPos = hoverObj->pos;
+            oldWorldPos = g_level->objects.pos[g_level->objects.rowOf(hoverObj)];
+        }
+    }
+    if (isDraggingObj && g_level->objects.contains(grabbedObj))
+    {
+        ImVec2 newPos(oldWorldPos.x + (currMousePos.x - mouseDownPos.x) / g_viz.getZoom(),
+                      oldWorldPos.y + (currMousePos.y - mouseDownPos.y) / g_viz.getZoom());
+        if (s_snapEnabled && !ImGui::GetIO().KeyAlt)
+        {
+            newPos = s_snapper.snap(g_level->objects, g_levelIndex, grabbedObj, newPos, currentSnapSettings(),
+                                    &g_selection);
+        } else
+        {
+            s_snapper.clearGuides();
         }
+
+        // Coalesces with the previous frames of this drag into one undo step
+        ImVec2 currPos = g_level->objects.pos[g_level->objects.rowOf(grabbedObj)];
+        ImVec2 delta(newPos.x - currPos.x, newPos.y - currPos.y);
+        if (delta.x != 0 || delta.y != 0) moveSelection(g_level->objects, g_levelIndex, g_undo, g_selection, delta);
+    }
+    if (!ImGui::IsMouseDown(0))
+    {
+        isDraggingObj = false;
+        s_snapper.clearGuides();
+    }
+}
+
+// Shift+drag on empty space adds everything the box touches to the selection
+static void handleBoxSelection(ImDrawList* drawList)
+{
+    static bool isBoxSelecting = false;
+    static ImVec2 mouseDownPos;
+    static std::vector<ObjectId> s_boxHits;
+
+    ImVec2 currMousePos = ImGui::GetIO().MousePos;
+    if (ImGui::IsItemHovered() && ImGui::IsMouseClicked(0) && ImGui::GetIO().KeyShift && !isBoxSelecting &&
+        !g_level->objects.contains(findObjectAtScreenPos(currMousePos)))
+    {
+        isBoxSelecting = true;
+        mouseDownPos = currMousePos;
     }
-    if (isDraggingObj)
+    if (!isBoxSelecting) return;
+
+    ImVec2 screenMin(std::min(mouseDownPos.x, currMousePos.x), std::min(mouseDownPos.y, currMousePos.y));
+    ImVec2 screenMax(std::max(mouseDownPos.x, currMousePos.x), std::max(mouseDownPos.y, currMousePos.y));
+    if (ImGui::IsMouseDown(0))
     {
-        g_selectedObj->pos = ImVec2(oldWorldPos.x + (currMousePos.x - mouseDownPos.x) / g_viz.getZoom(),
-                                  oldWorldPos.y + (currMousePos.y - mouseDownPos.y) / g_viz.getZoom());
-        if (!ImGui::IsMouseDown(0)) isDraggingObj = false;
+        drawList->AddRectFilled(screenMin, screenMax, IM_COL32(80, 140, 255, 40));
+        drawList->AddRect(screenMin, screenMax, IM_COL32(80, 140, 255, 255));
+        return;
+    }
+
+    isBoxSelecting = false;
+    g_levelIndex.queryRect(g_viz.screenToWorldSpace(screenMin), g_viz.screenToWorldSpace(screenMax), ImVec2(0, 0),
+                           s_boxHits);
+    for (ObjectId id : s_boxHits) g_selection.add(id);
+}
+
+static void showSnapGuides(ImDrawList* drawList)
+{
+    for (const SnapGuide& guide : s_snapper.guides())
+    {
+        ImU32 color = guide.kind == SnapGuideKind::ALIGN ? IM_COL32(255, 0, 255, 255) : IM_COL32(0, 220, 255, 255);
+        drawList->AddLine(g_viz.worldToScreenSpace(guide.start), g_viz.worldToScreenSpace(guide.end), color, 1.5f);
     }
 }
 
@@ -162,7 +481,8 @@ static void handleDraggingSpace()
 
     ImVec2 currMouseScreenPos = ImGui::GetIO().MousePos;
 
-    if (ImGui::IsItemHovered() && !isDraggingSpace && ImGui::IsMouseClicked(0) && !findObjectAtScreenPos(currMouseScreenPos))
+    if (ImGui::IsItemHovered() && !isDraggingSpace && ImGui::IsMouseClicked(0) && !ImGui::GetIO().KeyShift &&
+        !g_level->objects.contains(findObjectAtScreenPos(currMouseScreenPos)))
     {
         isDraggingSpace = true;
         mouseDownScreenPos = currMouseScreenPos;
@@ -178,42 +498,328 @@ static void handleDraggingSpace()
 
 void showLevelObjectSelection(ImDrawList *drawList)
 {
-    // Draw rect around selected object
-    if (g_selectedObj)
+    // Draw rect around selected objects, thicker for the one the properties editor shows
+    for (ObjectId id : g_selection.ids())
     {
+        if (!g_level->objects.contains(id)) continue;
         auto rectColor = IM_COL32(0, 50, 180, 255);
 
-        // TODO deduplicate this with showLevelObject()?
-        float scaledWidth = g_selectedObj->frameSize().x * g_selectedObj->scale;
-        float scaledHeight = g_selectedObj->frameSize().y * g_selectedObj->scale;
-
-        ImVec2 worldTexStart(g_selectedObj->pos.x - scaledWidth / 2,
-                             g_selectedObj->pos.y - scaledHeight / 2);
-        ImVec2 worldTexEnd(g_selectedObj->pos.x + scaledWidth / 2,
-                           g_selectedObj->pos.y + scaledHeight / 2);
+        ImVec2 worldTexStart, worldTexEnd;
+        getObjectWorldRect(g_level->objects, g_level->objects.rowOf(id), worldTexStart, worldTexEnd);
 
         ImVec2 screenStart = g_viz.worldToScreenSpace(worldTexStart);
         ImVec2 screenEnd = g_viz.worldToScreenSpace(worldTexEnd);
 
-        ImVec2 uv0(0, 0);
-        ImVec2 uv1(g_selectedObj->uvEnd());
+        drawList->AddRect(screenStart, screenEnd, rectColor, 2, ~0, id == g_selection.primary() ? 6 : 3);
+    }
+}
+
+static ImVec2 trajectoryLaunchVelocity()
+{
+    float angle = s_trajectory.angleDeg * 3.14159265f / 180;
+    return ImVec2(std::cos(angle) * s_trajectory.speed, std::sin(angle) * s_trajectory.speed);
+}
+
+static void showTrajectory(ImDrawList* drawList)
+{
+    const LevelObjects& objects = g_level->objects;
+    if (!s_trajectory.enabled || !objects.contains(g_level->player)) return;
+
+    constexpr float TIMESTEP = 1.f / 60;
+    if (!s_trajectory.valid || s_trajectory.levelRevision != g_levelIndex.revision() ||
+        s_trajectory.levelChanges != g_undo.changes())
+    {
+        s_trajectory.sim.setPlanets(objects, gravRangeRadiusPerScale(), s_gravity);
+        s_trajectory.sim.simulate(objects.pos[objects.rowOf(g_level->player)], trajectoryLaunchVelocity(), TIMESTEP,
+                                  static_cast<int>(s_trajectory.seconds / TIMESTEP), s_trajectory.path);
+        s_trajectory.valid = true;
+        s_trajectory.levelRevision = g_levelIndex.revision();
+        s_trajectory.levelChanges = g_undo.changes();
+    }
+
+    const std::vector<ImVec2>& worldPoints = s_trajectory.path.points;
+    FrameVector<ImVec2> screenPoints{ArenaAllocator<ImVec2>(g_frameArena)};
+    screenPoints.reserve(worldPoints.size());
+    for (ImVec2 point : worldPoints) screenPoints.push_back(g_viz.worldToScreenSpace(point));
+
+    const ImU32 pathColor = IM_COL32(255, 220, 80, 255);
+    drawList->AddPolyline(screenPoints.data(), static_cast<int>(screenPoints.size()), pathColor, false, 2);
+
+    // Launch direction, and where it crashed if it did
+    ImVec2 launchVel = trajectoryLaunchVelocity();
+    ImVec2 arrowEnd(worldPoints[0].x + launchVel.x * 0.25f, worldPoints[0].y + launchVel.y * 0.25f);
+    drawList->AddLine(screenPoints[0], g_viz.worldToScreenSpace(arrowEnd), IM_COL32(255, 120, 40, 255), 3);
+    if (s_trajectory.path.end == TrajectoryEnd::HIT_PLANET)
+    {
+        drawList->AddCircleFilled(screenPoints.back(), 6, IM_COL32(255, 60, 60, 255));
+    }
+}
+
+// Colors the canvas by the planets' pull, under the level objects
+static void showGravityField(ImDrawList* drawList)
+{
+    if (!s_showGravityField) return;
+    if (!s_fieldMap) s_fieldMap = std::make_unique<GravityFieldMap>();
+
+    // Texels of at least 4px, more if the canvas is too big for the map
+    constexpr int MAX_SIZE = GravityFieldMap::MAX_SIZE;
+    const Canvas& canvas = g_viz.getCanvas();
+    float texelPx = std::max(4.f, std::ceil(std::max(canvas.size.x, canvas.size.y) / MAX_SIZE));
+
+    GravityFieldView view;
+    view.worldOrigin = g_viz.screenToWorldSpace(canvas.start);
+    view.worldPerTexel = texelPx / g_viz.getZoom();
+    view.width = std::min(MAX_SIZE, static_cast<int>(std::ceil(canvas.size.x / texelPx)));
+    view.height = std::min(MAX_SIZE, static_cast<int>(std::ceil(canvas.size.y / texelPx)));
+    view.rangeRadiusPerScale = gravRangeRadiusPerScale();
+    view.gravity = s_gravity;
+    if (view.width <= 0 || view.height <= 0) return;
+
+    RowSpan rowsChanged = s_fieldMap->update(g_level->objects, view);
+    if (!s_fieldTex)
+    {
+        // Updated every time the field changes and never drawn tiny, so it's not worth a thumbnail
+        s_fieldTex = g_assetMan.createTexture(s_fieldMap->pixels(), MAX_SIZE, MAX_SIZE, "gravity field", false);
+    }
+    else if (rowsChanged.count > 0)
+    {
+        g_assetMan.updateTexture(*s_fieldTex, s_fieldMap->pixels(), rowsChanged.first, rowsChanged.count);
+    }
+
+    ImVec2 end(canvas.start.x + view.width * texelPx, canvas.start.y + view.height * texelPx);
+    drawList->AddImage(s_fieldTex->id, canvas.start, end, ImVec2(0, 0),
+                       ImVec2(static_cast<float>(view.width) / MAX_SIZE, static_cast<float>(view.height) / MAX_SIZE));
+}
+
+static void showGravityOptions()
+{
+    bool changed = ImGui::Checkbox("Show trajectory", &s_trajectory.enabled);
+    ImGui::SameLine();
+    ImGui::Checkbox("Show gravity field", &s_showGravityField);
+    if (!s_trajectory.enabled && !s_showGravityField) return;
 
-        drawList->AddRect(screenStart, screenEnd, rectColor, 2, ~0, 6);
+    ImGui::PushItemWidth(110);
+    ImGui::SameLine();
+    changed |= ImGui::SliderFloat("Gravity", &s_gravity, 0, 2000000, "%.0f", 2);
+    if (s_trajectory.enabled)
+    {
+        ImGui::SameLine();
+        changed |= ImGui::SliderFloat("Angle", &s_trajectory.angleDeg, -180, 180, "%.0f deg");
+        ImGui::SameLine();
+        changed |= ImGui::SliderFloat("Speed", &s_trajectory.speed, 0, 2000, "%.0f");
+        ImGui::SameLine();
+        changed |= ImGui::SliderFloat("Seconds", &s_trajectory.seconds, 1, 30, "%.0f");
+    }
+    ImGui::PopItemWidth();
+
+    if (changed) s_trajectory.valid = false;
+}
+
+static void updateReachability()
+{
+    if (s_reach.valid && s_reach.levelRevision == g_levelIndex.revision() && s_reach.levelChanges == g_undo.changes())
+    {
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    s_reach.analyzer.analyze(g_level->objects, ReachabilityParams{gravRangeRadiusPerScale(), s_reach.jumpDistance},
+                             s_reach.report);
+    s_reach.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    s_reach.valid = true;
+    s_reach.levelRevision = g_levelIndex.revision();
+    s_reach.levelChanges = g_undo.changes();
+}
+
+static void showReachabilityVerdict()
+{
+    const ReachabilityReport& report = s_reach.report;
+    const ImVec4 badColor(1, 0.4f, 0.4f, 1);
+    size_t food = report.recipeIndex + 1;
+    switch (report.verdict)
+    {
+    case ReachVerdict::SOLVABLE:
+        ImGui::TextColored(ImVec4(0.4f, 1, 0.4f, 1), "Solvable");
+        break;
+    case ReachVerdict::NO_START:
+        ImGui::TextColored(badColor, "Needs exactly one start planet");
+        break;
+    case ReachVerdict::NO_END:
+        ImGui::TextColored(badColor, "Needs exactly one end planet");
+        break;
+    case ReachVerdict::FOOD_OFF_PLANET:
+        ImGui::TextColored(badColor, "Food %zu isn't in any planet's gravity range", food);
+        break;
+    case ReachVerdict::FOOD_UNREACHABLE:
+        if (food == 1) ImGui::TextColored(badColor, "Can't get to food 1 from the start planet");
+        else ImGui::TextColored(badColor, "Can't get to food %zu from food %zu", food, food - 1);
+        break;
+    case ReachVerdict::END_UNREACHABLE:
+        ImGui::TextColored(badColor, "Can't get to the end planet after the last food");
+        break;
+    case ReachVerdict::FOOD_PLANET_UNREACHABLE:
+        ImGui::TextColored(badColor, "A planet with food can't be reached from the start");
+        break;
+    }
+
+    ImGui::SameLine();
+    ImGui::Text("(%zu planets unreachable, %.2f ms)", report.unreachablePlanets.size(), s_reach.ms);
+}
+
+static void showReachabilityOptions()
+{
+    bool changed = ImGui::Checkbox("Check solvable", &s_reach.enabled);
+    if (!s_reach.enabled) return;
+
+    ImGui::SameLine();
+    ImGui::PushItemWidth(110);
+    changed |= ImGui::SliderFloat("Jump distance", &s_reach.jumpDistance, 0, 2000, "%.0f");
+    ImGui::PopItemWidth();
+    if (changed) s_reach.valid = false;
+
+    updateReachability();
+    ImGui::SameLine();
+    showReachabilityVerdict();
+}
+
+// Circles the planets the player can't get to, and links the first part of the recipe's route that can't be done
+static void showReachability(ImDrawList* drawList)
+{
+    if (!s_reach.enabled) return;
+
+    const LevelObjects& objects = g_level->objects;
+    const ImU32 badColor = IM_COL32(255, 60, 60, 255);
+    auto planetCircle = [&](ObjectId id, float thickness) {
+        if (!objects.contains(id)) return;
+        size_t row = objects.rowOf(id);
+        float radius = objects.frameSize(row).x * objects.scale[row] / 2 * g_viz.getZoom();
+        drawList->AddCircle(g_viz.worldToScreenSpace(objects.pos[row]), radius + 4, badColor, 32, thickness);
+    };
+
+    for (ObjectId id : s_reach.report.unreachablePlanets) planetCircle(id, 2);
+
+    const ReachabilityReport& report = s_reach.report;
+    if (objects.contains(report.from) && objects.contains(report.to))
+    {
+        ImVec2 from = g_viz.worldToScreenSpace(objects.pos[objects.rowOf(report.from)]);
+        ImVec2 to = g_viz.worldToScreenSpace(objects.pos[objects.rowOf(report.to)]);
+        drawList->AddLine(from, to, badColor, 3);
+    }
+    planetCircle(report.to, 4);
+}
+
+// Outlines overlapping sprites, and links planets that sit in each other's gravity range
+static void showOverlaps(ImDrawList* drawList)
+{
+    if (!s_showOverlaps) return;
+    const LevelObjects& objects = g_level->objects;
+    s_overlaps.update(objects, gravRangeRadiusPerScale());
+
+    const Canvas& canvas = g_viz.getCanvas();
+    const ImU32 spriteColor = IM_COL32(255, 60, 60, 255);
+    const ImU32 rangeColor = IM_COL32(255, 150, 40, 255);
+    for (const OverlapPair& pair : s_overlaps.pairs())
+    {
+        size_t rowA = objects.rowOf(pair.a), rowB = objects.rowOf(pair.b);
+        ImVec2 startA, endA, startB, endB;
+        getObjectWorldRect(objects, rowA, startA, endA);
+        getObjectWorldRect(objects, rowB, startB, endB);
+        startA = g_viz.worldToScreenSpace(startA);
+        endA = g_viz.worldToScreenSpace(endA);
+        startB = g_viz.worldToScreenSpace(startB);
+        endB = g_viz.worldToScreenSpace(endB);
+
+        ImVec2 pairStart(std::min(startA.x, startB.x), std::min(startA.y, startB.y));
+        ImVec2 pairEnd(std::max(endA.x, endB.x), std::max(endA.y, endB.y));
+        if (!rectsOverlap(pairStart, pairEnd, canvas.start, canvas.end)) continue;
+
+        if (pair.kind == OverlapKind::SPRITES)
+        {
+            drawList->AddRect(startA, endA, spriteColor, 0, ~0, 2);
+            drawList->AddRect(startB, endB, spriteColor, 0, ~0, 2);
+        } else
+        {
+            drawList->AddLine(g_viz.worldToScreenSpace(objects.pos[rowA]), g_viz.worldToScreenSpace(objects.pos[rowB]),
+                              rangeColor, 2);
+        }
     }
 }
 
 void showVizOptions()
 {
     ImGui::Checkbox("Show gravity ranges", &g_showGravRanges);
+    ImGui::SameLine();
+    ImGui::Checkbox("Show stats", &s_showStatsOverlay);
+    ImGui::SameLine();
+    ImGui::Checkbox("Show overlaps", &s_showOverlaps);
+    if (s_showOverlaps && !s_overlaps.pairs().empty())
+    {
+        ImGui::SameLine();
+        ImGui::TextColored(ImVec4(1, 0.6f, 0.2f, 1), "(%zu)", s_overlaps.pairs().size());
+    }
 
     ImGui::SameLine();
     float zoomLog = std::log(g_viz.getZoom());
     ImGui::SliderFloat("Zoom", &zoomLog, std::log(MIN_ZOOM), std::log(MAX_ZOOM));
     g_viz.setZoom(std::exp(zoomLog));
+
+    ImGui::SliderFloat("Simplify objects smaller than", &s_lodThresholdPx, 0, 128, "%.0f px");
+    ImGui::SameLine();
+    ImGui::Checkbox("Snap (hold Alt to drag freely)", &s_snapEnabled);
+
+    showGravityOptions();
+    showReachabilityOptions();
+
+    // Counted against the visible canvas each time it's drawn (see countVisibleSprites())
+    ImGui::Text("Objects drawn: %d (%d as thumbnails), culled: %d", s_stats.objectsDrawn, s_stats.objectsLod,
+                s_stats.objectsCulled);
+    if (g_showGravRanges)
+    {
+        ImGui::SameLine();
+        ImGui::Text("Gravity ranges drawn: %d (%d as outlines), culled: %d", s_stats.rangesDrawn, s_stats.rangesLod,
+                    s_stats.rangesCulled);
+    }
+}
+
+// Frame numbers for lag reports, over the canvas' top right corner. They're from the previous frame, since this
+// one is still being built.
+static void showStatsOverlay()
+{
+    const FrameStatsHistory& history = recentFrameStats();
+    if (history.size() == 0) return;
+    const FrameStats& last = history.latest();
+
+    constexpr float WIDTH = 330;
+    constexpr float PLOT_HEIGHT = 40;
+    constexpr float MARGIN = 10;
+    const ImGuiStyle& style = ImGui::GetStyle();
+    float height = 5 * ImGui::GetTextLineHeightWithSpacing() + PLOT_HEIGHT + style.ItemSpacing.y + 2 * style.WindowPadding.y;
+
+    const Canvas& canvas = g_viz.getCanvas();
+    ImGui::SetCursorScreenPos(ImVec2(canvas.end.x - WIDTH - MARGIN, canvas.start.y + MARGIN));
+    ImGui::PushStyleColor(ImGuiCol_ChildBg, ImVec4(0, 0, 0, 0.6f));
+    // No inputs, so drags and clicks go through to the canvas underneath
+    ImGui::BeginChild("stats overlay", ImVec2(WIDTH, height), false, ImGuiWindowFlags_NoInputs | ImGuiWindowFlags_NoScrollbar);
+
+    ImGui::Text("Build ms  p50 %.2f  p95 %.2f  p99 %.2f", history.buildMsPercentile(0.5f),
+                history.buildMsPercentile(0.95f), history.buildMsPercentile(0.99f));
+    char overlayText[32];
+    snprintf(overlayText, sizeof(overlayText), "last %.2f ms", last.buildMs);
+    ImGui::PlotLines("##build ms", history.buildMs(), history.size(), history.offset(), overlayText, 0, FLT_MAX,
+                     ImVec2(WIDTH - 2 * style.WindowPadding.x, PLOT_HEIGHT));
+    ImGui::Text("Draw calls: %d, texture binds: %d", last.drawCmds, last.textureBinds);
+    ImGui::Text("Vertices: %d, indices: %d", last.vtxCount, last.idxCount);
+    ImGui::Text("Uploaded: %.1f KB", last.bytesUploaded / 1024.0);
+    ImGui::Text("Objects drawn: %d, culled: %d", s_stats.objectsDrawn, s_stats.objectsCulled);
+
+    ImGui::EndChild();
+    ImGui::PopStyleColor();
 }
 
 void showLevelVisualizer()
 {
+    PROFILE_ZONE("showLevelVisualizer");
+    ALLOC_SCOPE(AllocTag::VISUALIZER);
     // Set a default size for this window for first run, in case we have no .ini
     // Necessary in this case I believe because we don't add any actual content to the window besides the
     // implicitly-sized drawing list, so it's otherwise empty
@@ -223,10 +829,20 @@ void showLevelVisualizer()
 
     if (!g_level)
     {
+        s_stats = VisualizerStats{};
+        s_canvasCache.valid = false;
         ImGui::End();
         return;
     }
 
+    // Catch levels that were swapped in without going through openLevelJson()
+    if (!g_levelIndex.isBuiltFor(g_level))
+    {
+        g_levelIndex.rebuild(g_level);
+        g_undo.clear();
+    }
+    g_selection.removeMissing(g_level->objects);
+
     showVizOptions();
 
     ImDrawList* drawList = ImGui::GetWindowDrawList();
@@ -240,20 +856,19 @@ void showLevelVisualizer()
     handleScrollWheel();
     handleDraggingObject();
     handleDraggingSpace();
-    showLevelGrid(drawList);
+    s_gridRenderer->draw(drawList, g_viz);
+    showGravityField(drawList);
 
-    for (auto& planet : g_level->planets)
-    {
-        showLevelObject(drawList, planet);
-    }
-    for (auto& food : g_level->foods)
-    {
-        showLevelObject(drawList, food);
-    }
-    showLevelObject(drawList, g_level->player);
-    showLevelObject(drawList, g_level->customer);
+    showLevelObjects(drawList);
+    showTrajectory(drawList);
+    showReachability(drawList);
+    showOverlaps(drawList);
 
     showLevelObjectSelection(drawList);
+    showSnapGuides(drawList);
+    handleBoxSelection(drawList); // Last, so the box draws over everything
+
+    if (s_showStatsOverlay) showStatsOverlay();
 
     ImGui::End();
 }
@@ -1,3 +1,32 @@
 #pragma once
 
-void showLevelVisualizer();
\ No newline at end of file
+#include "gridrenderer.h"
+#include "spriterenderer.h"
+
+#include <memory>
+
+struct VisualizerStats
+{
+    int objectsDrawn;
+    int objectsCulled;
+    int objectsLod; // Drawn from thumbnails, included in objectsDrawn
+    int rangesDrawn;
+    int rangesCulled;
+    int rangesLod; // Drawn as outlines, included in rangesDrawn
+};
+
+void showLevelVisualizer();
+
+// Defaults to ImGuiSpriteRenderer, which works without GL
+void setSpriteRenderer(std::unique_ptr<SpriteRenderer> renderer);
+
+// Defaults to ImGuiGridRenderer
+void setGridRenderer(std::unique_ptr<GridRenderer> renderer);
+
+// On by default. Sprites are kept around in world space and only rebuilt when the level, zoom or gravity range
+// toggle changes, textures finish loading or the view pans far enough; turning this off rebuilds them for the
+// exact view every frame.
+void setCanvasCacheEnabled(bool enabled);
+
+// Counts for the visible canvas, as of the last frame drawn
+const VisualizerStats& getVisualizerStats();
\ No newline at end of file